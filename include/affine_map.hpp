@@ -0,0 +1,165 @@
+#ifndef _AFFINE_MAP_HPP_
+#define _AFFINE_MAP_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_batch.hpp>
+#include <polynomial_utils.hpp>
+
+#include <cassert>
+#include <vector>
+
+namespace Numerical {
+
+/* Composes polynomials of a fixed degree with the affine
+ * map y = A x + b, ie. computes q(x) = p(A x + b).
+ * Row i of A holds the coefficients of x for y_i.
+ * x may have fewer variables than y, ie. to restrict p to
+ * a face, in which case q has _domain_dim variables.
+ * The composition is linear in p's coefficients, so the
+ * map is stored as the matrix taking p's coefficients to
+ * q's; column k holds the expansion of monomial k of y in
+ * x, built from the expansion of a monomial one degree
+ * lower times one of the y_i.
+ * The monomials of degree n only expand into terms of
+ * degree n or less, so only the leading rows of a column
+ * may be nonzero; for square maps the matrix is block
+ * upper triangular in Polynomial's coefficient order.
+ */
+template <typename CoeffT, int _degree, int _dim,
+          int _domain_dim = _dim>
+class AffineMap {
+ public:
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  using Batch = PolynomialBatch<CoeffT, _degree, _dim>;
+  using DomainPoly =
+      Polynomial<CoeffT, _degree, _domain_dim>;
+  using DomainBatch =
+      PolynomialBatch<CoeffT, _degree, _domain_dim>;
+  using Matrix = Array<Array<CoeffT, _domain_dim>, _dim>;
+  static constexpr const int num_coeffs = Poly::num_coeffs;
+  static constexpr const int num_domain_coeffs =
+      DomainPoly::num_coeffs;
+
+  static_assert(_domain_dim <= _dim,
+                "Affine maps can't increase the number of "
+                "variables");
+
+  AffineMap(const Matrix &A, const Array<CoeffT, _dim> &b)
+      : matrix(num_domain_coeffs * num_coeffs,
+               CoeffTraits<CoeffT>::zero()),
+        rows(num_coeffs) {
+    const std::vector<Array<int, _dim> > terms =
+        Utilities::term_exponents<_dim>(_degree);
+    const std::vector<Array<int, _domain_dim> >
+        domain_terms =
+            Utilities::term_exponents<_domain_dim>(_degree);
+    mutable_column(0)[0] = CoeffTraits<CoeffT>::one();
+    rows[0] = 1;
+    for(int k = 1; k < num_coeffs; k++) {
+      /* Monomial k is y_d times the monomial with one less
+       * power of y_d, whose column is already built */
+      Array<int, _dim> lower(terms[k]);
+      int d = 0;
+      while(lower[d] == 0) {
+        d++;
+      }
+      lower[d]--;
+      const int prev = Utilities::term_index(lower);
+      const CoeffT *src = column(prev);
+      CoeffT *dest = mutable_column(k);
+      rows[k] = Utilities::poly_num_coeffs(
+          Utilities::basis_degree(k, _dim), _domain_dim);
+      for(int i = 0; i < rows[prev]; i++) {
+        if(CoeffTraits<CoeffT>::is_zero(src[i])) {
+          continue;
+        }
+        dest[i] = CoeffTraits<CoeffT>::fma(src[i], b[d],
+                                           dest[i]);
+        for(int j = 0; j < _domain_dim; j++) {
+          Array<int, _domain_dim> raised(domain_terms[i]);
+          raised[j]++;
+          CoeffT &c = dest[Utilities::term_index(raised)];
+          c = CoeffTraits<CoeffT>::fma(src[i], A[d][j], c);
+        }
+      }
+    }
+  }
+
+  /* The coefficients of the expansion of monomial k */
+  const CoeffT *column(int k) const noexcept {
+    assert(k >= 0);
+    assert(k < num_coeffs);
+    return &matrix[k * num_domain_coeffs];
+  }
+
+  DomainPoly compose(const Poly &p) const noexcept {
+    DomainPoly q((Tags::Zero_Tag()));
+    for(int k = 0; k < num_coeffs; k++) {
+      const CoeffT &c = p.data()[k];
+      if(CoeffTraits<CoeffT>::is_zero(c)) {
+        continue;
+      }
+      const CoeffT *col = column(k);
+      for(int i = 0; i < rows[k]; i++) {
+        q.data()[i] = CoeffTraits<CoeffT>::fma(
+            col[i], c, q.data()[i]);
+      }
+    }
+    return q;
+  }
+
+  /* Composes count polynomials, writing them to out */
+  void compose(const Poly *polys, int count,
+               DomainPoly *out) const noexcept {
+    for(int i = 0; i < count; i++) {
+      out[i] = compose(polys[i]);
+    }
+  }
+
+  /* Composes every polynomial of the batch; each entry of
+   * the matrix scales a row of the batch */
+  DomainBatch compose(const Batch &polys) const noexcept {
+    DomainBatch out(polys.size(), Tags::Zero_Tag());
+    for(int k = 0; k < num_coeffs; k++) {
+      const CoeffT *col = column(k);
+      const CoeffT *src = polys.coeffs(k);
+      for(int i = 0; i < rows[k]; i++) {
+        if(CoeffTraits<CoeffT>::is_zero(col[i])) {
+          continue;
+        }
+        CoeffT *dest = out.coeffs(i);
+        for(int p = 0; p < polys.size(); p++) {
+          dest[p] = CoeffTraits<CoeffT>::fma(
+              src[p], col[i], dest[p]);
+        }
+      }
+    }
+    return out;
+  }
+
+ private:
+  CoeffT *mutable_column(int k) noexcept {
+    return &matrix[k * num_domain_coeffs];
+  }
+
+  /* Column major */
+  std::vector<CoeffT> matrix;
+  /* The number of rows which may be nonzero in each
+   * column */
+  std::vector<int> rows;
+};
+
+/* Computes p(A x + b); use an AffineMap to compose many
+ * polynomials with the same map */
+template <typename CoeffT, int _degree, int _dim>
+Polynomial<CoeffT, _degree, _dim> affine_compose(
+    const Polynomial<CoeffT, _degree, _dim> &p,
+    const Array<Array<CoeffT, _dim>, _dim> &A,
+    const Array<CoeffT, _dim> &b) {
+  return AffineMap<CoeffT, _degree, _dim>(A, b).compose(p);
+}
+}  // namespace Numerical
+
+#endif  // _AFFINE_MAP_HPP_
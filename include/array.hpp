@@ -7,82 +7,121 @@
 #include <algorithm>
 #include <cassert>
 #include <initializer_list>
+#include <type_traits>
 
 #include <iostream>
 
 #include "cudadef.h"
 
-template <typename T, int sz>
-struct Array {
+namespace ArrayInternal {
+
+template <typename T>
+constexpr bool all_convertible() {
+  return true;
+}
+
+template <typename T, typename src_t, typename... src_list>
+constexpr bool all_convertible() {
+  return std::is_convertible<src_t, T>::value &&
+         all_convertible<T, src_list...>();
+}
+}  // namespace ArrayInternal
+
+/* A fixed size array.
+ * The copy and move operations are the implicit ones, so
+ * Array is trivially copyable whenever T is, and copies of
+ * it (and of the Polynomials built on it) can be lowered
+ * to memcpy or vector moves.
+ * align optionally over-aligns the storage, ie. to 32 or
+ * 64 bytes for vector loads and stores; note that heap
+ * allocations aren't over-aligned before C++17
+ */
+template <typename T, int sz, int align = alignof(T)>
+struct alignas(align) Array {
+  static_assert(align >= int(alignof(T)),
+                "Array can't be less aligned than T");
+  static_assert((align & (align - 1)) == 0,
+                "Array alignment must be a power of two");
+
   T data[sz];
 
-  CUDA_CALLABLE Array() {}
+  Array() = default;
 
-  CUDA_CALLABLE Array(const Tags::Zero_Tag &) {
+  CUDA_CALLABLE constexpr Array(const Tags::Zero_Tag &)
+      : data() {
     for(int i = 0; i < sz; i++) {
       data[i] = T(0);
     }
   }
 
-  CUDA_CALLABLE Array(const Array<T, sz> &src) {
+  CUDA_CALLABLE constexpr Array(const T src[sz]) : data() {
     for(int i = 0; i < sz; i++) {
       data[i] = src[i];
     }
   }
 
-  CUDA_CALLABLE Array(const T src[sz]) {
-    for(int i = 0; i < sz; i++) {
-      data[i] = src[i];
+  CUDA_CALLABLE constexpr Array(
+      std::initializer_list<T> src)
+      : data() {
+    assert(src.size() <= std::size_t(sz));
+    int i = 0;
+    for(const T &v : src) {
+      data[i++] = v;
     }
   }
 
-  CUDA_CALLABLE Array(std::initializer_list<T> src) {
-    std::copy(src.begin(), src.end(), data);
-  }
-
   template <typename... src_t,
-            typename std::enable_if<sizeof...(src_t) == sz,
-                                    int>::type = 0>
-  CUDA_CALLABLE Array(src_t... src) {
-    set_values(0, src...);
-  }
-
-  CUDA_CALLABLE ~Array() {}
-
-  CUDA_CALLABLE const T &operator[](int idx) const {
+            typename std::enable_if<
+                sizeof...(src_t) == sz &&
+                    ArrayInternal::all_convertible<
+                        T, src_t...>(),
+                int>::type = 0>
+  CUDA_CALLABLE constexpr Array(src_t... src)
+      : data{static_cast<T>(src)...} {}
+
+  CUDA_CALLABLE constexpr const T &operator[](
+      int idx) const {
     assert(idx >= 0);
     assert(idx < sz);
     return data[idx];
   }
 
-  CUDA_CALLABLE T &operator[](int idx) {
+  CUDA_CALLABLE constexpr T &operator[](int idx) {
     assert(idx >= 0);
     assert(idx < sz);
     return data[idx];
   }
 
-  CUDA_CALLABLE Array<T, sz> operator=(
-      const Array<T, sz> &src) {
+  CUDA_CALLABLE static constexpr int size() { return sz; }
+
+  CUDA_CALLABLE constexpr bool operator==(
+      const Array &other) const {
     for(int i = 0; i < sz; i++) {
-      data[i] = src[i];
+      if(!(data[i] == other[i])) {
+        return false;
+      }
     }
-    return *this;
+    return true;
   }
 
-  CUDA_CALLABLE static constexpr int size() { return sz; }
+  CUDA_CALLABLE constexpr bool operator!=(
+      const Array &other) const {
+    return !(*this == other);
+  }
 
   template <typename... src_t>
-  void set_values(int idx, T cur_val, src_t... values) {
+  constexpr void set_values(int idx, T cur_val,
+                            src_t... values) {
     data[idx] = cur_val;
     set_values(idx + 1, values...);
   }
 
-  void set_values(int idx, T final_val) {
+  constexpr void set_values(int idx, T final_val) {
     data[idx] = final_val;
   }
 
   friend std::ostream &operator<<(std::ostream &os,
-                                  const Array<T, sz> &a) {
+                                  const Array &a) {
     bool once = false;
     os << "[ ";
     for(int idx = 0; idx < sz; idx++) {
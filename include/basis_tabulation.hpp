@@ -0,0 +1,269 @@
+#ifndef _BASIS_TABULATION_HPP_
+#define _BASIS_TABULATION_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_eval.hpp>
+#include <polynomial_utils.hpp>
+#include <quadrature.hpp>
+#include <vector_polynomial.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+/* The values, gradients and optionally Hessians of every
+ * function of a basis_tuple at a quadrature rule's points
+ * on the reference element; they're the same for every
+ * element, so they're computed once and shared with
+ * cached().
+ * Each table is num_functions rows of stride() entries,
+ * with row f holding function f at every point, so an
+ * element's values at the points are a row vector of its
+ * coefficients times the table, ie. a GEMM over a batch of
+ * elements.
+ * Rows start on alignment byte boundaries and are padded
+ * with zeros to a multiple of it; the weights are padded
+ * the same way, so kernels can run over whole rows.
+ * Hessian entries are stored once for each v <= w.
+ */
+template <typename CoeffT, int _max_degree, int _dim>
+class BasisTabulation {
+ public:
+  using tuple_type =
+      typename Utilities::basis_tuple<CoeffT, _max_degree,
+                                      _dim>::tuple_type;
+  using Rule = Quadrature<CoeffT, _dim>;
+  using Poly = Polynomial<CoeffT, _max_degree, _dim>;
+  static constexpr const int dim = _dim;
+  static constexpr const int num_functions =
+      std::tuple_size<tuple_type>::value;
+  static constexpr const int num_hessians =
+      _dim * (_dim + 1) / 2;
+  static constexpr const int alignment = 64;
+  static constexpr const int row_multiple =
+      alignment % sizeof(CoeffT) == 0
+          ? alignment / int(sizeof(CoeffT))
+          : 1;
+
+  BasisTabulation(const tuple_type &basis, const Rule &rule,
+                  bool with_hessians = false)
+      : quad(rule),
+        npoints(rule.size()),
+        row_stride((npoints + row_multiple - 1) /
+                   row_multiple * row_multiple),
+        hessians_stored(with_hessians) {
+    const int rows =
+        1 + num_functions *
+                (1 + _dim +
+                 (with_hessians ? num_hessians : 0));
+    storage.assign(rows * row_stride + row_multiple,
+                   CoeffTraits<CoeffT>::zero());
+    const std::uintptr_t addr =
+        reinterpret_cast<std::uintptr_t>(storage.data());
+    const std::uintptr_t aligned =
+        (addr + alignment - 1) &
+        ~(std::uintptr_t(alignment) - 1);
+    base = row_multiple > 1
+               ? reinterpret_cast<CoeffT *>(aligned)
+               : storage.data();
+
+    for(int q = 0; q < npoints; q++) {
+      base[q] = rule.weight(q);
+    }
+    std::vector<Poly> functions = widen(
+        basis, std::make_integer_sequence<int,
+                                          num_functions>());
+    const BatchEvaluator<CoeffT, _max_degree, _dim>
+        evaluator(rule.points());
+    for(int f = 0; f < num_functions; f++) {
+      evaluator.eval(functions[f], row(values_row(f)));
+      for(int v = 0; v < _dim; v++) {
+        const Poly d = differentiate(functions[f], v);
+        evaluator.eval(d, row(gradient_row(v, f)));
+        if(!with_hessians) {
+          continue;
+        }
+        for(int w = v; w < _dim; w++) {
+          evaluator.eval(differentiate(d, w),
+                         row(hessian_row(v, w, f)));
+        }
+      }
+    }
+  }
+
+  BasisTabulation(const BasisTabulation &) = delete;
+  BasisTabulation &operator=(const BasisTabulation &) =
+      delete;
+
+  /* The tabulation of basis at rule's points, shared by
+   * every caller in the process which asks for the same
+   * basis coefficients and rule points and weights; it's
+   * only computed on the first request */
+  static std::shared_ptr<const BasisTabulation> cached(
+      const tuple_type &basis, const Rule &rule,
+      bool with_hessians = false) {
+    static std::mutex cache_lock;
+    static std::map<std::vector<CoeffT>,
+                    std::shared_ptr<const BasisTabulation> >
+        cache;
+    std::vector<CoeffT> key;
+    for(const Poly &p : widen(
+            basis, std::make_integer_sequence<
+                       int, num_functions>())) {
+      key.insert(key.end(), p.data(),
+                 p.data() + p.num_coeffs);
+    }
+    for(int q = 0; q < rule.size(); q++) {
+      for(int d = 0; d < _dim; d++) {
+        key.push_back(rule.point(q)[d]);
+      }
+      key.push_back(rule.weight(q));
+    }
+    std::lock_guard<std::mutex> guard(cache_lock);
+    std::shared_ptr<const BasisTabulation> &entry =
+        cache[key];
+    if(!entry ||
+       (with_hessians && !entry->has_hessians())) {
+      entry = std::make_shared<const BasisTabulation>(
+          basis, rule, with_hessians);
+    }
+    return entry;
+  }
+
+  const Rule &rule() const noexcept { return quad; }
+
+  int num_points() const noexcept { return npoints; }
+
+  /* The length of every row, a multiple of row_multiple */
+  int stride() const noexcept { return row_stride; }
+
+  bool has_hessians() const noexcept {
+    return hessians_stored;
+  }
+
+  const CoeffT *weights() const noexcept { return base; }
+
+  /* Function f at every point; the rows of the functions
+   * after it follow at multiples of stride() */
+  const CoeffT *values(int f = 0) const noexcept {
+    return row(values_row(f));
+  }
+
+  /* d function f / d x_v at every point */
+  const CoeffT *gradients(int v, int f = 0) const noexcept {
+    return row(gradient_row(v, f));
+  }
+
+  /* d^2 function f / d x_v d x_w at every point */
+  const CoeffT *hessians(int v, int w, int f = 0) const
+      noexcept {
+    assert(hessians_stored);
+    return v <= w ? row(hessian_row(v, w, f))
+                  : row(hessian_row(w, v, f));
+  }
+
+  /* Writes the sum of dofs[f] times table row f to out,
+   * which must hold stride() values; table is values() or
+   * gradients(v) */
+  void interpolate(const CoeffT *table, const CoeffT *dofs,
+                   CoeffT *out) const noexcept {
+    for(int q = 0; q < row_stride; q++) {
+      out[q] = CoeffTraits<CoeffT>::zero();
+    }
+    for(int f = 0; f < num_functions; f++) {
+      const CoeffT *r = table + f * row_stride;
+      for(int q = 0; q < row_stride; q++) {
+        out[q] =
+            CoeffTraits<CoeffT>::fma(dofs[f], r[q], out[q]);
+      }
+    }
+  }
+
+ private:
+  template <int... _indices>
+  static std::vector<Poly> widen(
+      const tuple_type &basis,
+      std::integer_sequence<int, _indices...>) {
+    std::vector<Poly> functions(num_functions,
+                                Poly(Tags::Zero_Tag()));
+    using expander = int[];
+    (void)expander{
+        0, (copy_coeffs(std::get<_indices>(basis),
+                        functions[_indices]),
+            0)...};
+    return functions;
+  }
+
+  /* Storage is graded, so the lower degree coefficients
+   * are a prefix of the higher degree ones */
+  template <int _degree>
+  static void copy_coeffs(
+      const Polynomial<CoeffT, _degree, _dim> &src,
+      Poly &dest) noexcept {
+    for(int k = 0; k < src.num_coeffs; k++) {
+      dest.data()[k] = src.data()[k];
+    }
+  }
+
+  /* The derivative, kept in the same storage */
+  static Poly differentiate(const Poly &p, int v) {
+    const auto &table =
+        Internal::derivative_table<_max_degree, _dim>();
+    Poly d((Tags::Zero_Tag()));
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      const int target = table.first[k][v];
+      if(target >= 0) {
+        d.data()[target] =
+            p.data()[k] * CoeffTraits<CoeffT>::broadcast(
+                              table.exponents[k][v]);
+      }
+    }
+    return d;
+  }
+
+  static int values_row(int f) noexcept {
+    assert(f >= 0);
+    assert(f < num_functions);
+    return 1 + f;
+  }
+
+  static int gradient_row(int v, int f) noexcept {
+    assert(v >= 0);
+    assert(v < _dim);
+    return values_row(f) + (1 + v) * num_functions;
+  }
+
+  static int hessian_row(int v, int w, int f) noexcept {
+    assert(v <= w);
+    assert(w < _dim);
+    const int h = v * _dim - v * (v - 1) / 2 + (w - v);
+    return values_row(f) + (1 + _dim + h) * num_functions;
+  }
+
+  CoeffT *row(int r) noexcept {
+    return base + r * row_stride;
+  }
+
+  const CoeffT *row(int r) const noexcept {
+    return base + r * row_stride;
+  }
+
+  Rule quad;
+  int npoints;
+  int row_stride;
+  bool hessians_stored;
+  std::vector<CoeffT> storage;
+  CoeffT *base;
+};
+}  // namespace Numerical
+
+#endif  // _BASIS_TABULATION_HPP_
@@ -0,0 +1,371 @@
+#ifndef _BERNSTEIN_HPP_
+#define _BERNSTEIN_HPP_
+
+#include <array.hpp>
+#include <ctmath.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+#include <tags.hpp>
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+/* A polynomial on [0, 1]^_dim in the tensor product
+ * Bernstein basis of degree _degree in every variable,
+ * B_i0(x_0) B_i1(x_1) ..., with
+ * B_i(x) = C(_degree, i) x^i (1 - x)^(_degree - i).
+ * The Bernstein basis is much better conditioned than the
+ * monomials on the unit box, and since it's a partition of
+ * unity with nonnegative functions the polynomial lies in
+ * the convex hull of its coefficients, which bounds it
+ * without evaluating it anywhere.
+ * Coefficients are stored with the last variable's index
+ * varying fastest.
+ * Every Polynomial of total degree _degree has a
+ * representation in this basis; the converse only holds
+ * when the terms of higher total degree cancel.
+ */
+template <typename CoeffT, int _degree, int _dim>
+class BernsteinPolynomial {
+ public:
+  static constexpr const int dim = _dim;
+  static constexpr const int degree = _degree;
+  static constexpr const int order = _degree + 1;
+  static constexpr const int num_coeffs =
+      CTMath::power(order, _dim);
+
+  static_assert(_degree >= 0,
+                "A polynomial's degree must be at least "
+                "zero");
+  static_assert(_dim > 0,
+                "A Bernstein polynomial needs at least one "
+                "variable");
+
+  BernsteinPolynomial() {}
+
+  BernsteinPolynomial(const Tags::Zero_Tag &)
+      : coeffs(Tags::Zero_Tag()) {}
+
+  /* Converts the monomial coefficients one variable at a
+   * time, x^j = sum_{i >= j} C(i, j) / C(_degree, j) B_i */
+  explicit BernsteinPolynomial(
+      const Polynomial<CoeffT, _degree, _dim> &p)
+      : coeffs(Tags::Zero_Tag()) {
+    p.coeff_iterator(
+        [&](const Array<int, _dim> &exponents) {
+          coeffs[flat_index(exponents)] =
+              p.coeff(exponents);
+        });
+    const Matrix to_bernstein = monomial_to_bernstein();
+    for(int d = 0; d < _dim; d++) {
+      apply_axis(to_bernstein, d);
+    }
+  }
+
+  /* Converts to the monomial basis. The terms of total
+   * degree greater than _degree are dropped; they're zero
+   * up to rounding for polynomials converted from a
+   * Polynomial */
+  Polynomial<CoeffT, _degree, _dim> to_monomial() const {
+    BernsteinPolynomial m(*this);
+    const Matrix to_monomial = bernstein_to_monomial();
+    for(int d = 0; d < _dim; d++) {
+      m.apply_axis(to_monomial, d);
+    }
+    Polynomial<CoeffT, _degree, _dim> p((Tags::Zero_Tag()));
+    for(int i = 0; i < num_coeffs; i++) {
+      const Array<int, _dim> exponents = multi_index(i);
+      if(CTMath::sum(exponents) <= _degree) {
+        p.coeff(exponents) = m.coeffs[i];
+      }
+    }
+    return p;
+  }
+
+  CoeffT *data() noexcept { return &coeffs[0]; }
+
+  const CoeffT *data() const noexcept { return &coeffs[0]; }
+
+  template <typename... int_list,
+            typename std::enable_if<
+                sizeof...(int_list) == _dim, int>::type = 0>
+  CoeffT coeff(int_list... args) const noexcept {
+    return coeffs[flat_index(Array<int, _dim>(args...))];
+  }
+
+  template <typename... int_list,
+            typename std::enable_if<
+                sizeof...(int_list) == _dim, int>::type = 0>
+  CoeffT &coeff(int_list... args) noexcept {
+    return coeffs[flat_index(Array<int, _dim>(args...))];
+  }
+
+  CoeffT coeff(const Array<int, _dim> &indices) const
+      noexcept {
+    return coeffs[flat_index(indices)];
+  }
+
+  CoeffT &coeff(const Array<int, _dim> &indices) noexcept {
+    return coeffs[flat_index(indices)];
+  }
+
+  /* Evaluates with de Casteljau's algorithm one variable
+   * at a time: each step applies the 1D algorithm to every
+   * fiber along the first remaining variable at once, with
+   * the fibers innermost so the updates vectorize, and
+   * leaves a Bernstein polynomial of one less variable;
+   * this is O(_degree^(_dim + 1)) */
+  CoeffT eval(const Array<CoeffT, _dim> &point) const {
+    std::vector<CoeffT> work(coeffs.data,
+                             coeffs.data + num_coeffs);
+    int fiber_size = num_coeffs;
+    for(int d = 0; d < _dim; d++) {
+      fiber_size /= order;
+      const CoeffT t = point[d];
+      const CoeffT s = CoeffTraits<CoeffT>::one() - t;
+      for(int r = 1; r <= _degree; r++) {
+        for(int i = 0; i <= _degree - r; i++) {
+          CoeffT *lower = &work[i * fiber_size];
+          const CoeffT *upper = lower + fiber_size;
+          for(int f = 0; f < fiber_size; f++) {
+            lower[f] = s * lower[f] + t * upper[f];
+          }
+        }
+      }
+    }
+    return work[0];
+  }
+
+  template <typename... subs_list,
+            typename std::enable_if<
+                sizeof...(subs_list) == _dim,
+                int>::type = 0>
+  CoeffT eval(subs_list... vars) const {
+    return eval(Array<CoeffT, _dim>(vars...));
+  }
+
+  /* The smallest and largest coefficients, which bound the
+   * polynomial on [0, 1]^_dim */
+  std::pair<CoeffT, CoeffT> bounds() const noexcept {
+    std::pair<CoeffT, CoeffT> b(coeffs[0], coeffs[0]);
+    for(int i = 1; i < num_coeffs; i++) {
+      if(coeffs[i] < b.first) {
+        b.first = coeffs[i];
+      }
+      if(b.second < coeffs[i]) {
+        b.second = coeffs[i];
+      }
+    }
+    return b;
+  }
+
+  /* Represents the polynomial in the basis of degree
+   * new_degree. Raising the degree is exact; lowering it
+   * inverts degree elevation, and like change_degree it's
+   * only exact when the polynomial is of the lower degree
+   */
+  template <int new_degree>
+  BernsteinPolynomial<CoeffT, new_degree, _dim>
+  change_degree() const {
+    std::vector<CoeffT> cur(coeffs.data,
+                            coeffs.data + num_coeffs);
+    int cur_degree = _degree;
+    while(cur_degree != new_degree) {
+      const int next_degree =
+          cur_degree < new_degree ? cur_degree + 1
+                                  : cur_degree - 1;
+      for(int d = 0; d < _dim; d++) {
+        /* Only axis d changes its degree, so the axes
+         * before it are already at next_degree */
+        const int outer =
+            CTMath::power(next_degree + 1, d);
+        const int inner =
+            CTMath::power(cur_degree + 1, _dim - d - 1);
+        std::vector<CoeffT> axis(
+            outer * (next_degree + 1) * inner);
+        for(int o = 0; o < outer; o++) {
+          for(int f = 0; f < inner; f++) {
+            const CoeffT *src =
+                &cur[o * (cur_degree + 1) * inner + f];
+            CoeffT *dest =
+                &axis[o * (next_degree + 1) * inner + f];
+            if(next_degree > cur_degree) {
+              elevate(src, dest, cur_degree, inner);
+            } else {
+              reduce(src, dest, next_degree, inner);
+            }
+          }
+        }
+        cur.swap(axis);
+      }
+      cur_degree = next_degree;
+    }
+    BernsteinPolynomial<CoeffT, new_degree, _dim> b;
+    for(int i = 0; i < int(cur.size()); i++) {
+      b.data()[i] = cur[i];
+    }
+    return b;
+  }
+
+  BernsteinPolynomial operator+(
+      const BernsteinPolynomial &rhs) const noexcept {
+    BernsteinPolynomial s;
+    for(int i = 0; i < num_coeffs; i++) {
+      s.coeffs[i] = coeffs[i] + rhs.coeffs[i];
+    }
+    return s;
+  }
+
+  BernsteinPolynomial operator-(
+      const BernsteinPolynomial &rhs) const noexcept {
+    BernsteinPolynomial s;
+    for(int i = 0; i < num_coeffs; i++) {
+      s.coeffs[i] = coeffs[i] - rhs.coeffs[i];
+    }
+    return s;
+  }
+
+  BernsteinPolynomial operator*(const CoeffT &scale) const
+      noexcept {
+    BernsteinPolynomial s;
+    for(int i = 0; i < num_coeffs; i++) {
+      s.coeffs[i] = coeffs[i] * scale;
+    }
+    return s;
+  }
+
+ private:
+  using Matrix = Array<Array<CoeffT, order>, order>;
+
+  static int flat_index(
+      const Array<int, _dim> &indices) noexcept {
+    int idx = 0;
+    for(int d = 0; d < _dim; d++) {
+      assert(indices[d] >= 0);
+      assert(indices[d] <= _degree);
+      idx = idx * order + indices[d];
+    }
+    return idx;
+  }
+
+  static Array<int, _dim> multi_index(int idx) noexcept {
+    Array<int, _dim> indices;
+    for(int d = _dim - 1; d >= 0; d--) {
+      indices[d] = idx % order;
+      idx /= order;
+    }
+    return indices;
+  }
+
+  static CoeffT binomial(int n, int k) {
+    return CoeffTraits<CoeffT>::broadcast(
+        CTMath::n_choose_k<long long>(n, k));
+  }
+
+  /* M[i][j] is the Bernstein coefficient i of x^j */
+  static Matrix monomial_to_bernstein() {
+    Matrix M;
+    for(int i = 0; i < order; i++) {
+      for(int j = 0; j < order; j++) {
+        M[i][j] = binomial(i, j) / binomial(_degree, j);
+      }
+    }
+    return M;
+  }
+
+  /* M[j][i] is the coefficient of x^j in B_i,
+   * (-1)^(j - i) C(_degree, j) C(j, i) */
+  static Matrix bernstein_to_monomial() {
+    Matrix M;
+    for(int j = 0; j < order; j++) {
+      for(int i = 0; i < order; i++) {
+        const CoeffT m =
+            binomial(_degree, j) * binomial(j, i);
+        M[j][i] = (j - i) % 2 == 0 ? m : -m;
+      }
+    }
+    return M;
+  }
+
+  /* Multiplies every fiber along the axis by M */
+  void apply_axis(const Matrix &M, int axis) noexcept {
+    const int inner = CTMath::power(order, _dim - axis - 1);
+    const int outer = num_coeffs / (inner * order);
+    Array<CoeffT, order> fiber;
+    for(int o = 0; o < outer; o++) {
+      for(int f = 0; f < inner; f++) {
+        CoeffT *c = &coeffs[o * order * inner + f];
+        for(int i = 0; i < order; i++) {
+          fiber[i] = c[i * inner];
+        }
+        for(int i = 0; i < order; i++) {
+          CoeffT sum = CoeffTraits<CoeffT>::zero();
+          for(int j = 0; j < order; j++) {
+            sum = CoeffTraits<CoeffT>::fma(
+                M[i][j], fiber[j], sum);
+          }
+          c[i * inner] = sum;
+        }
+      }
+    }
+  }
+
+  /* Elevates the fiber of degree n with the given stride
+   * to degree n + 1,
+   * e_i = i / (n + 1) c_(i - 1) + (1 - i / (n + 1)) c_i */
+  static void elevate(const CoeffT *src, CoeffT *dest,
+                      int n, int stride) noexcept {
+    const CoeffT scale =
+        CoeffTraits<CoeffT>::one() /
+        CoeffTraits<CoeffT>::broadcast(n + 1);
+    dest[0] = src[0];
+    for(int i = 1; i <= n; i++) {
+      const CoeffT w =
+          CoeffTraits<CoeffT>::broadcast(i) * scale;
+      const CoeffT v = CoeffTraits<CoeffT>::one() - w;
+      dest[i * stride] = w * src[(i - 1) * stride] +
+                         v * src[i * stride];
+    }
+    dest[(n + 1) * stride] = src[n * stride];
+  }
+
+  /* Inverts elevate from degree n + 1 to n.
+   * Each recurrence amplifies rounding errors as it goes,
+   * so the lower half of the coefficients is solved for
+   * from the lowest, and the upper half from the highest */
+  static void reduce(const CoeffT *src, CoeffT *dest, int n,
+                     int stride) noexcept {
+    const CoeffT scale =
+        CoeffTraits<CoeffT>::broadcast(n + 1);
+    const int mid = n / 2;
+    dest[0] = src[0];
+    for(int i = 1; i <= mid; i++) {
+      dest[i * stride] =
+          (scale * src[i * stride] -
+           CoeffTraits<CoeffT>::broadcast(i) *
+               dest[(i - 1) * stride]) /
+          CoeffTraits<CoeffT>::broadcast(n + 1 - i);
+    }
+    if(n == 0) {
+      return;
+    }
+    dest[n * stride] = src[(n + 1) * stride];
+    for(int i = n; i > mid + 1; i--) {
+      dest[(i - 1) * stride] =
+          (scale * src[i * stride] -
+           CoeffTraits<CoeffT>::broadcast(n + 1 - i) *
+               dest[i * stride]) /
+          CoeffTraits<CoeffT>::broadcast(i);
+    }
+  }
+
+  Array<CoeffT, num_coeffs> coeffs;
+};
+}  // namespace Numerical
+
+#endif  // _BERNSTEIN_HPP_
@@ -4,17 +4,77 @@
 
 #include <array.hpp>
 
+#include <limits>
+#include <stdexcept>
+
 namespace CTMath {
 
 template <typename int_t>
-constexpr int_t partialFactorial(int_t minv,
-                                 int_t maxv) noexcept {
-  /* Computes (maxv!) / (minv!) */
-  return maxv > minv
-             ? maxv * partialFactorial(minv, maxv - 1)
-             : minv > maxv ? 1 : minv > 0 ? minv : 1;
+constexpr int_t partialFactorial(int_t minv, int_t maxv) {
+  /* Computes minv (minv + 1) ... maxv, ie. (maxv!) / ((minv
+   * - 1)!), which is 1 when minv > maxv.
+   * Throws std::overflow_error if it doesn't fit in int_t;
+   * in a constant expression that's a compile error */
+  int_t result = 1;
+  for(int_t i = minv > 1 ? minv : 1; i <= maxv; i++) {
+    if(__builtin_mul_overflow(result, i, &result)) {
+      throw std::overflow_error(
+          "partialFactorial overflowed");
+    }
+  }
+  return result;
 }
 
+namespace Internal {
+
+/* The rows of Pascal's triangle which fit in a long long;
+ * C(67, 33) doesn't */
+constexpr const int binomial_rows = 67;
+
+/* Pascal's triangle, built by additions at compile time.
+ * Row n starts at n (n + 1) / 2.
+ */
+struct BinomialTable {
+  long long values[binomial_rows * (binomial_rows + 1) / 2];
+
+  static constexpr int row_start(int n) noexcept {
+    return n * (n + 1) / 2;
+  }
+
+  constexpr BinomialTable() : values() {
+    for(int n = 0; n < binomial_rows; n++) {
+      values[row_start(n)] = 1;
+      values[row_start(n) + n] = 1;
+      for(int k = 1; k < n; k++) {
+        long long v = 0;
+        if(__builtin_add_overflow(
+               values[row_start(n - 1) + k - 1],
+               values[row_start(n - 1) + k], &v)) {
+          /* Makes the constant table ill-formed if
+           * binomial_rows is too large */
+          throw std::overflow_error(
+              "Binomial table overflowed");
+        }
+        values[row_start(n) + k] = v;
+      }
+    }
+  }
+
+  constexpr long long operator()(int n, int k) const {
+    return values[row_start(n) + k];
+  }
+};
+
+template <typename Dummy = void>
+struct Binomials {
+  static constexpr const BinomialTable table =
+      BinomialTable();
+};
+
+template <typename Dummy>
+constexpr const BinomialTable Binomials<Dummy>::table;
+}  // namespace Internal
+
 template <typename int_t>
 constexpr int_t sum(int_t arg) noexcept {
   return arg;
@@ -45,14 +105,33 @@ constexpr int_t product(int_t arg0,
 }
 
 template <typename int_t>
-constexpr int_t n_choose_k(int_t choices,
-                           int_t num) noexcept {
-  return (choices - num) > num
-             ? partialFactorial(choices - num + 1,
-                                choices) /
-                   partialFactorial(1, num)
-             : partialFactorial(num + 1, choices) /
-                   partialFactorial(1, choices - num);
+constexpr int_t power(int_t base, int exponent) noexcept {
+  int_t result = 1;
+  for(int i = 0; i < exponent; i++) {
+    result *= base;
+  }
+  return result;
+}
+
+template <typename int_t>
+constexpr int_t n_choose_k(int_t choices, int_t num) {
+  /* Looked up in Pascal's triangle; this is 0 when num is
+   * out of [0, choices].
+   * Throws std::overflow_error if it doesn't fit in int_t;
+   * in a constant expression that's a compile error */
+  return num < 0 || num > choices
+             ? 0
+             : choices >= Internal::binomial_rows ||
+                       static_cast<unsigned long long>(
+                           Internal::Binomials<>::table(
+                               int(choices), int(num))) >
+                           static_cast<unsigned long long>(
+                               std::numeric_limits<
+                                   int_t>::max())
+                   ? throw std::overflow_error(
+                         "n_choose_k overflowed")
+                   : int_t(Internal::Binomials<>::table(
+                         int(choices), int(num)));
 }
 }
 
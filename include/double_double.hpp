@@ -0,0 +1,226 @@
+#ifndef _DOUBLE_DOUBLE_HPP_
+#define _DOUBLE_DOUBLE_HPP_
+
+#include <fraction.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+
+namespace Numerical {
+
+/* A number represented by the unevaluated sum of two
+ * doubles, hi + lo with |lo| <= ulp(hi) / 2, giving about
+ * 106 bits of significand.
+ * The arithmetic is built from error-free transformations
+ * (Dekker and Knuth's two-sum, and two-product by fma),
+ * following Hida, Li and Bailey's QD library.
+ * These rely on every operation being rounded as written,
+ * so this must not be compiled with -ffast-math or
+ * -ffp-contract=fast.
+ */
+class DoubleDouble {
+ public:
+  constexpr DoubleDouble(double hi = 0.0) noexcept
+      : hi(hi), lo(0.0) {}
+
+  constexpr DoubleDouble(double hi, double lo) noexcept
+      : hi(hi), lo(lo) {}
+
+  /* Integers are split so that 64 bit values are exact */
+  template <typename Int,
+            typename std::enable_if<
+                std::is_integral<Int>::value,
+                int>::type = 0>
+  DoubleDouble(Int val) noexcept
+      : hi(double(val)),
+        lo(double(__int128(val) - __int128(hi))) {}
+
+  /* Rounds the fraction to the nearest double-double */
+  explicit DoubleDouble(const Fraction &f) noexcept
+      : DoubleDouble(DoubleDouble(f.numerator()) /
+                     DoubleDouble(f.denominator())) {}
+
+  double high() const noexcept { return hi; }
+
+  double low() const noexcept { return lo; }
+
+  explicit operator double() const noexcept { return hi; }
+
+  explicit operator long double() const noexcept {
+    return static_cast<long double>(hi) + lo;
+  }
+
+  DoubleDouble operator-() const noexcept {
+    return DoubleDouble(-hi, -lo);
+  }
+
+  friend DoubleDouble operator+(const DoubleDouble &a,
+                                const DoubleDouble &b)
+      noexcept {
+    double s1, s2, t1, t2;
+    two_sum(a.hi, b.hi, s1, s2);
+    two_sum(a.lo, b.lo, t1, t2);
+    s2 += t1;
+    quick_two_sum(s1, s2, s1, s2);
+    s2 += t2;
+    quick_two_sum(s1, s2, s1, s2);
+    return DoubleDouble(s1, s2);
+  }
+
+  friend DoubleDouble operator+(const DoubleDouble &a,
+                                double b) noexcept {
+    double s1, s2;
+    two_sum(a.hi, b, s1, s2);
+    s2 += a.lo;
+    quick_two_sum(s1, s2, s1, s2);
+    return DoubleDouble(s1, s2);
+  }
+
+  friend DoubleDouble operator+(
+      double a, const DoubleDouble &b) noexcept {
+    return b + a;
+  }
+
+  friend DoubleDouble operator-(const DoubleDouble &a,
+                                const DoubleDouble &b)
+      noexcept {
+    return a + (-b);
+  }
+
+  friend DoubleDouble operator*(const DoubleDouble &a,
+                                const DoubleDouble &b)
+      noexcept {
+    double p1, p2;
+    two_prod(a.hi, b.hi, p1, p2);
+    p2 += a.hi * b.lo + a.lo * b.hi;
+    quick_two_sum(p1, p2, p1, p2);
+    return DoubleDouble(p1, p2);
+  }
+
+  friend DoubleDouble operator*(const DoubleDouble &a,
+                                double b) noexcept {
+    double p1, p2;
+    two_prod(a.hi, b, p1, p2);
+    p2 += a.lo * b;
+    quick_two_sum(p1, p2, p1, p2);
+    return DoubleDouble(p1, p2);
+  }
+
+  friend DoubleDouble operator*(
+      double a, const DoubleDouble &b) noexcept {
+    return b * a;
+  }
+
+  friend DoubleDouble operator/(const DoubleDouble &a,
+                                const DoubleDouble &b)
+      noexcept {
+    /* Long division, with a third quotient digit to correct
+     * the rounding of the second */
+    double q1 = a.hi / b.hi;
+    DoubleDouble r = a - b * q1;
+    double q2 = r.hi / b.hi;
+    r = r - b * q2;
+    const double q3 = r.hi / b.hi;
+    quick_two_sum(q1, q2, q1, q2);
+    return DoubleDouble(q1, q2) + q3;
+  }
+
+  DoubleDouble &operator+=(const DoubleDouble &v) noexcept {
+    return *this = *this + v;
+  }
+
+  DoubleDouble &operator-=(const DoubleDouble &v) noexcept {
+    return *this = *this - v;
+  }
+
+  DoubleDouble &operator*=(const DoubleDouble &v) noexcept {
+    return *this = *this * v;
+  }
+
+  DoubleDouble &operator/=(const DoubleDouble &v) noexcept {
+    return *this = *this / v;
+  }
+
+  /* Comparisons assume both values are normalized */
+  friend bool operator==(const DoubleDouble &a,
+                         const DoubleDouble &b) noexcept {
+    return a.hi == b.hi && a.lo == b.lo;
+  }
+
+  friend bool operator!=(const DoubleDouble &a,
+                         const DoubleDouble &b) noexcept {
+    return !(a == b);
+  }
+
+  friend bool operator<(const DoubleDouble &a,
+                        const DoubleDouble &b) noexcept {
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+  }
+
+  friend bool operator>(const DoubleDouble &a,
+                        const DoubleDouble &b) noexcept {
+    return b < a;
+  }
+
+  friend bool operator<=(const DoubleDouble &a,
+                         const DoubleDouble &b) noexcept {
+    return !(b < a);
+  }
+
+  friend bool operator>=(const DoubleDouble &a,
+                         const DoubleDouble &b) noexcept {
+    return !(a < b);
+  }
+
+  friend DoubleDouble abs(const DoubleDouble &a) noexcept {
+    return a.hi < 0.0 ? -a : a;
+  }
+
+  friend DoubleDouble sqrt(const DoubleDouble &a) noexcept {
+    /* One Newton step from the double approximation
+     * (Karp's trick), which doubles the correct bits */
+    if(a.hi <= 0.0) {
+      return DoubleDouble(std::sqrt(a.hi));
+    }
+    const double x = 1.0 / std::sqrt(a.hi);
+    const double ax = a.hi * x;
+    const DoubleDouble ax_dd(ax);
+    const double correction =
+        (a - ax_dd * ax_dd).hi * (x * 0.5);
+    return ax_dd + correction;
+  }
+
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const DoubleDouble &v) {
+    return os << static_cast<long double>(v);
+  }
+
+ private:
+  /* s + err == a + b exactly */
+  static void two_sum(double a, double b, double &s,
+                      double &err) noexcept {
+    s = a + b;
+    const double bb = s - a;
+    err = (a - (s - bb)) + (b - bb);
+  }
+
+  /* As two_sum, but requires |a| >= |b| */
+  static void quick_two_sum(double a, double b, double &s,
+                            double &err) noexcept {
+    s = a + b;
+    err = b - (s - a);
+  }
+
+  /* p + err == a * b exactly */
+  static void two_prod(double a, double b, double &p,
+                       double &err) noexcept {
+    p = a * b;
+    err = std::fma(a, b, -p);
+  }
+
+  double hi, lo;
+};
+}  // namespace Numerical
+
+#endif  // _DOUBLE_DOUBLE_HPP_
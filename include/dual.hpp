@@ -0,0 +1,203 @@
+#ifndef _DUAL_HPP_
+#define _DUAL_HPP_
+
+#include <array.hpp>
+#include <tags.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+namespace Numerical {
+
+/* A forward mode automatic differentiation number: a value
+ * and its derivatives with respect to N seed directions.
+ * Every operation applies the chain rule to all N
+ * derivatives at once, so evaluating a function of Duals
+ * gives N directional derivatives for the cost of one
+ * (wider) evaluation.
+ * T may itself be a Dual, which gives second derivatives.
+ */
+template <typename T, int N>
+class Dual {
+  static_assert(N > 0,
+                "A Dual needs at least one derivative");
+
+ public:
+  Dual() {}
+
+  /* Constants have zero derivatives */
+  Dual(const T &value)
+      : val(value), grad(Tags::Zero_Tag()) {}
+
+  template <typename ScalarT,
+            typename std::enable_if<
+                std::is_arithmetic<ScalarT>::value,
+                int>::type = 0>
+  Dual(ScalarT value)
+      : val(T(value)), grad(Tags::Zero_Tag()) {}
+
+  Dual(const T &value, const Array<T, N> &derivatives)
+      : val(value), grad(derivatives) {}
+
+  /* The independent variable of the seed direction slot */
+  static Dual variable(const T &value, int slot) {
+    assert(slot >= 0);
+    assert(slot < N);
+    Dual d(value);
+    d.grad[slot] = T(1);
+    return d;
+  }
+
+  static constexpr int size() noexcept { return N; }
+
+  const T &value() const noexcept { return val; }
+
+  T &value() noexcept { return val; }
+
+  const T &derivative(int slot) const noexcept {
+    return grad[slot];
+  }
+
+  T &derivative(int slot) noexcept { return grad[slot]; }
+
+  Dual operator-() const {
+    Dual d;
+    d.val = -val;
+    for(int i = 0; i < N; i++) {
+      d.grad[i] = -grad[i];
+    }
+    return d;
+  }
+
+  friend Dual operator+(const Dual &a, const Dual &b) {
+    Dual d;
+    d.val = a.val + b.val;
+    for(int i = 0; i < N; i++) {
+      d.grad[i] = a.grad[i] + b.grad[i];
+    }
+    return d;
+  }
+
+  friend Dual operator-(const Dual &a, const Dual &b) {
+    Dual d;
+    d.val = a.val - b.val;
+    for(int i = 0; i < N; i++) {
+      d.grad[i] = a.grad[i] - b.grad[i];
+    }
+    return d;
+  }
+
+  friend Dual operator*(const Dual &a, const Dual &b) {
+    Dual d;
+    d.val = a.val * b.val;
+    for(int i = 0; i < N; i++) {
+      d.grad[i] = a.grad[i] * b.val + a.val * b.grad[i];
+    }
+    return d;
+  }
+
+  friend Dual operator/(const Dual &a, const Dual &b) {
+    /* (a / b)' = (a' - (a / b) b') / b */
+    Dual d;
+    d.val = a.val / b.val;
+    for(int i = 0; i < N; i++) {
+      d.grad[i] = (a.grad[i] - d.val * b.grad[i]) / b.val;
+    }
+    return d;
+  }
+
+  Dual &operator+=(const Dual &v) {
+    return *this = *this + v;
+  }
+
+  Dual &operator-=(const Dual &v) {
+    return *this = *this - v;
+  }
+
+  Dual &operator*=(const Dual &v) {
+    return *this = *this * v;
+  }
+
+  Dual &operator/=(const Dual &v) {
+    return *this = *this / v;
+  }
+
+  /* Equal only if the values and all derivatives are */
+  friend bool operator==(const Dual &a, const Dual &b) {
+    return a.val == b.val && a.grad == b.grad;
+  }
+
+  friend bool operator!=(const Dual &a, const Dual &b) {
+    return !(a == b);
+  }
+
+  friend Dual sqrt(const Dual &a) {
+    using std::sqrt;
+    Dual d;
+    d.val = sqrt(a.val);
+    const T scale = T(1) / (T(2) * d.val);
+    for(int i = 0; i < N; i++) {
+      d.grad[i] = a.grad[i] * scale;
+    }
+    return d;
+  }
+
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const Dual &d) {
+    os << d.val << " " << d.grad;
+    return os;
+  }
+
+ private:
+  T val;
+  Array<T, N> grad;
+};
+
+/* Computes the Jacobian of residual, row-major, at u.
+ * residual(in, out) must fill out with num_residuals Duals
+ * computed from the num_dofs inputs in; it's called once
+ * for every block of N degrees of freedom, with the block
+ * seeded as the N independent variables.
+ * Returns the residual's value at u in value when given.
+ */
+template <int N, typename T, typename Residual>
+void jacobian(Residual &&residual, const std::vector<T> &u,
+              int num_residuals, std::vector<T> &J,
+              std::vector<T> *value = nullptr) {
+  using D = Dual<T, N>;
+  const int num_dofs = int(u.size());
+  J.assign(num_residuals * num_dofs, T(0));
+  std::vector<D> in(num_dofs);
+  std::vector<D> out(num_residuals);
+  for(int i = 0; i < num_dofs; i++) {
+    in[i] = D(u[i]);
+  }
+  for(int block = 0; block < num_dofs; block += N) {
+    const int width = std::min(N, num_dofs - block);
+    for(int s = 0; s < width; s++) {
+      in[block + s] = D::variable(u[block + s], s);
+    }
+    residual(static_cast<const std::vector<D> &>(in), out);
+    for(int r = 0; r < num_residuals; r++) {
+      for(int s = 0; s < width; s++) {
+        J[r * num_dofs + block + s] = out[r].derivative(s);
+      }
+    }
+    for(int s = 0; s < width; s++) {
+      in[block + s] = D(u[block + s]);
+    }
+    if(value != nullptr && block == 0) {
+      value->resize(num_residuals);
+      for(int r = 0; r < num_residuals; r++) {
+        (*value)[r] = out[r].value();
+      }
+    }
+  }
+}
+}  // namespace Numerical
+
+#endif  // _DUAL_HPP_
@@ -0,0 +1,545 @@
+#ifndef _DYNAMIC_POLYNOMIAL_HPP_
+#define _DYNAMIC_POLYNOMIAL_HPP_
+
+#include <array.hpp>
+#include <ctmath.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+#include <tags.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+/* Recycles coefficient blocks by their size.
+ * Blocks are carved from slabs of blocks_per_slab blocks,
+ * and go back to the free list for their size when they're
+ * released; memory is only returned to the system when the
+ * pool is destroyed, so it must outlive every polynomial
+ * allocated from it.
+ * This isn't thread safe, use one pool per thread.
+ */
+template <typename CoeffT>
+class CoefficientPool {
+  static_assert(alignof(CoeffT) <=
+                    alignof(std::max_align_t),
+                "Pooled coefficients can't be "
+                "over-aligned");
+
+ public:
+  explicit CoefficientPool(int blocks_per_slab = 64)
+      : blocks_per_slab(blocks_per_slab), reserved(0) {
+    assert(blocks_per_slab > 0);
+  }
+
+  CoefficientPool(const CoefficientPool &) = delete;
+  CoefficientPool &operator=(const CoefficientPool &) =
+      delete;
+
+  ~CoefficientPool() {
+    for(void *slab : slabs) {
+      ::operator delete(slab);
+    }
+  }
+
+  /* Returns uninitialized storage for size coefficients */
+  CoeffT *allocate(int size) {
+    assert(size > 0);
+    FreeList &list = free_list(size);
+    if(list.blocks.empty()) {
+      refill(list);
+    }
+    CoeffT *block = list.blocks.back();
+    list.blocks.pop_back();
+    return block;
+  }
+
+  void deallocate(CoeffT *block, int size) {
+    free_list(size).blocks.push_back(block);
+  }
+
+  /* The number of bytes held by the pool's slabs */
+  std::size_t bytes_reserved() const noexcept {
+    return reserved;
+  }
+
+ private:
+  struct FreeList {
+    int size;
+    std::vector<CoeffT *> blocks;
+  };
+
+  /* There are only a few distinct sizes, one per degree in
+   * use, so a linear search is fast */
+  FreeList &free_list(int size) {
+    for(FreeList &list : lists) {
+      if(list.size == size) {
+        return list;
+      }
+    }
+    lists.push_back(FreeList{size, {}});
+    return lists.back();
+  }
+
+  void refill(FreeList &list) {
+    const std::size_t bytes = std::size_t(blocks_per_slab) *
+                              list.size * sizeof(CoeffT);
+    CoeffT *slab =
+        static_cast<CoeffT *>(::operator new(bytes));
+    slabs.push_back(slab);
+    reserved += bytes;
+    for(int b = blocks_per_slab - 1; b >= 0; b--) {
+      list.blocks.push_back(slab + b * list.size);
+    }
+  }
+
+  int blocks_per_slab;
+  std::size_t reserved;
+  std::vector<FreeList> lists;
+  std::vector<void *> slabs;
+};
+
+/* A polynomial whose degree is chosen at runtime.
+ * The coefficients are stored contiguously in the same
+ * order as Polynomial stores them, ie. by increasing term
+ * degree, so converting to or from a Polynomial is a
+ * straight copy of the coefficients, and changing the
+ * degree keeps every coefficient at its index.
+ * Coefficients are allocated from the pool when one is
+ * given, and from the heap otherwise; the results of
+ * arithmetic are allocated from the left operand's pool.
+ * A moved from polynomial is empty, with degree 0 and no
+ * coefficients; it can be copied, assigned to, given a
+ * degree with set_degree, or destroyed.
+ */
+template <typename CoeffT, int _dim>
+class DynamicPolynomial {
+ public:
+  static constexpr const int dim = _dim;
+  using Pool = CoefficientPool<CoeffT>;
+
+  static_assert(_dim >= 0,
+                "A polynomial's _dimension must be at "
+                "least zero, otherwise it's degenerate");
+
+  /* The coefficients are default initialized, so they're
+   * unset for scalar types, like Polynomial() */
+  explicit DynamicPolynomial(int degree = 0,
+                             Pool *pool = nullptr)
+      : pool(pool) {
+    allocate(degree);
+    for(int i = 0; i < size; i++) {
+      new(coeffs + i) CoeffT;
+    }
+  }
+
+  DynamicPolynomial(int degree, const Tags::Zero_Tag &,
+                    Pool *pool = nullptr)
+      : pool(pool) {
+    allocate(degree);
+    std::uninitialized_fill(coeffs, coeffs + size,
+                            CoeffTraits<CoeffT>::zero());
+  }
+
+  template <int _degree>
+  explicit DynamicPolynomial(
+      const Polynomial<CoeffT, _degree, _dim> &p,
+      Pool *pool = nullptr)
+      : pool(pool) {
+    allocate(_degree);
+    std::uninitialized_copy(p.data(), p.data() + size,
+                            coeffs);
+  }
+
+  DynamicPolynomial(const DynamicPolynomial &p)
+      : pool(p.pool), coeffs(nullptr), deg(0), size(0) {
+    if(p.coeffs == nullptr) {
+      return;
+    }
+    allocate(p.deg);
+    std::uninitialized_copy(p.coeffs, p.coeffs + size,
+                            coeffs);
+  }
+
+  DynamicPolynomial(DynamicPolynomial &&p) noexcept
+      : pool(p.pool),
+        coeffs(p.coeffs),
+        deg(p.deg),
+        size(p.size) {
+    p.coeffs = nullptr;
+    p.deg = 0;
+    p.size = 0;
+  }
+
+  DynamicPolynomial &operator=(const DynamicPolynomial &p) {
+    if(this != &p) {
+      if(size == p.size) {
+        std::copy(p.coeffs, p.coeffs + size, coeffs);
+        deg = p.deg;
+      } else {
+        DynamicPolynomial copy(p);
+        swap(copy);
+      }
+    }
+    return *this;
+  }
+
+  DynamicPolynomial &operator=(
+      DynamicPolynomial &&p) noexcept {
+    swap(p);
+    return *this;
+  }
+
+  ~DynamicPolynomial() { release(); }
+
+  void swap(DynamicPolynomial &p) noexcept {
+    std::swap(pool, p.pool);
+    std::swap(coeffs, p.coeffs);
+    std::swap(deg, p.deg);
+    std::swap(size, p.size);
+  }
+
+  /* Copies the coefficients into a fixed degree
+   * polynomial, which must have at least this degree */
+  template <int _degree>
+  Polynomial<CoeffT, _degree, _dim> to_fixed() const {
+    assert(deg <= _degree);
+    using Fixed = Polynomial<CoeffT, _degree, _dim>;
+    Fixed p;
+    std::copy(coeffs, coeffs + size, p.data());
+    std::fill(p.data() + size,
+              p.data() + Fixed::num_coeffs,
+              CoeffTraits<CoeffT>::zero());
+    return p;
+  }
+
+  int degree() const noexcept { return deg; }
+
+  int num_coeffs() const noexcept { return size; }
+
+  Pool *allocator() const noexcept { return pool; }
+
+  CoeffT *data() noexcept { return coeffs; }
+
+  const CoeffT *data() const noexcept { return coeffs; }
+
+  /* Raises or lowers the degree; raising it zeros the new
+   * terms, lowering it drops the higher degree terms */
+  void set_degree(int degree) {
+    if(degree == deg) {
+      return;
+    }
+    DynamicPolynomial p(degree, pool);
+    const int common = std::min(size, p.size);
+    std::copy(coeffs, coeffs + common, p.coeffs);
+    std::fill(p.coeffs + common, p.coeffs + p.size,
+              CoeffTraits<CoeffT>::zero());
+    swap(p);
+  }
+
+  template <typename... int_list,
+            typename std::enable_if<
+                sizeof...(int_list) == _dim, int>::type = 0>
+  CoeffT coeff(int_list... args) const noexcept {
+    return coeff(Array<int, _dim>(args...));
+  }
+
+  template <typename... int_list,
+            typename std::enable_if<
+                sizeof...(int_list) == _dim, int>::type = 0>
+  CoeffT &coeff(int_list... args) noexcept {
+    return coeff(Array<int, _dim>(args...));
+  }
+
+  CoeffT coeff(const Array<int, _dim> &exponents) const
+      noexcept {
+    return coeffs[index(exponents)];
+  }
+
+  CoeffT &coeff(
+      const Array<int, _dim> &exponents) noexcept {
+    return coeffs[index(exponents)];
+  }
+
+  /* Calls function(exponents, idx) for every term, where
+   * idx is the index of the term's coefficient in data() */
+  template <typename Function>
+  void coeff_iterator(Function &&function) const {
+    Array<int, _dim> exponents;
+    int idx = 0;
+    if(_dim == 0) {
+      function(exponents, idx);
+      return;
+    }
+    for(int term_degree = 0; term_degree <= deg;
+        term_degree++) {
+      coeff_iterator(0, term_degree, exponents, idx,
+                     function);
+    }
+  }
+
+  DynamicPolynomial operator+(CoeffT val) const {
+    DynamicPolynomial p(*this);
+    p.coeffs[0] += val;
+    return p;
+  }
+
+  DynamicPolynomial operator-(CoeffT val) const {
+    return *this + (-val);
+  }
+
+  DynamicPolynomial operator-() const {
+    DynamicPolynomial p(deg, pool);
+    for(int i = 0; i < size; i++) {
+      p.coeffs[i] = -coeffs[i];
+    }
+    return p;
+  }
+
+  DynamicPolynomial operator*(CoeffT val) const {
+    DynamicPolynomial p(deg, pool);
+    for(int i = 0; i < size; i++) {
+      p.coeffs[i] = coeffs[i] * val;
+    }
+    return p;
+  }
+
+  /* The sum has the larger of the two degrees; since the
+   * layouts are graded, it's the elementwise sum of the
+   * common prefix of the coefficients */
+  DynamicPolynomial operator+(
+      const DynamicPolynomial &m) const {
+    const DynamicPolynomial &larger =
+        size >= m.size ? *this : m;
+    const DynamicPolynomial &smaller =
+        size >= m.size ? m : *this;
+    DynamicPolynomial s(larger.deg, pool);
+    for(int i = 0; i < smaller.size; i++) {
+      s.coeffs[i] = larger.coeffs[i] + smaller.coeffs[i];
+    }
+    std::copy(larger.coeffs + smaller.size,
+              larger.coeffs + larger.size,
+              s.coeffs + smaller.size);
+    return s;
+  }
+
+  DynamicPolynomial operator-(
+      const DynamicPolynomial &m) const {
+    return *this + (-m);
+  }
+
+  DynamicPolynomial operator*(
+      const DynamicPolynomial &m) const {
+    return product(m);
+  }
+
+  DynamicPolynomial product(
+      const DynamicPolynomial &m) const {
+    DynamicPolynomial prod(deg + m.deg, Tags::Zero_Tag(),
+                           pool);
+    Array<int, _dim> sum_exps;
+    coeff_iterator([&](const Array<int, _dim> &e1,
+                       int i1) {
+      m.coeff_iterator([&](const Array<int, _dim> &e2,
+                           int i2) {
+        for(int d = 0; d < _dim; d++) {
+          sum_exps[d] = e1[d] + e2[d];
+        }
+        CoeffT &c = prod.coeffs[index(sum_exps)];
+        c = CoeffTraits<CoeffT>::fma(coeffs[i1],
+                                     m.coeffs[i2], c);
+      });
+    });
+    return prod;
+  }
+
+  DynamicPolynomial integrate(
+      int variable, CoeffT constant = 0) const {
+    assert(variable >= 0);
+    assert(variable < _dim);
+    DynamicPolynomial integral(deg + 1, Tags::Zero_Tag(),
+                               pool);
+    Array<int, _dim> integral_eq;
+    coeff_iterator([&](const Array<int, _dim> &exponents,
+                       int i) {
+      integral_eq = exponents;
+      integral_eq[variable]++;
+      integral.coeffs[index(integral_eq)] =
+          coeffs[i] /
+          CoeffTraits<CoeffT>::broadcast(
+              integral_eq[variable]);
+    });
+    integral.coeffs[0] = constant;
+    return integral;
+  }
+
+  /* The derivative of a constant is the zero constant */
+  DynamicPolynomial differentiate(int variable) const {
+    assert(variable >= 0);
+    assert(variable < _dim);
+    DynamicPolynomial derivative(
+        std::max(deg - 1, 0), Tags::Zero_Tag(), pool);
+    Array<int, _dim> buf;
+    coeff_iterator([&](const Array<int, _dim> &exponents,
+                       int i) {
+      if(exponents[variable] > 0) {
+        buf = exponents;
+        buf[variable]--;
+        derivative.coeffs[index(buf)] =
+            CoeffTraits<CoeffT>::broadcast(
+                exponents[variable]) *
+            coeffs[i];
+      }
+    });
+    return derivative;
+  }
+
+  DynamicPolynomial<CoeffT, _dim - 1> slice(
+      const int slice_dim, const CoeffT slice_pos) const {
+    assert(slice_dim >= 0);
+    assert(slice_dim < _dim);
+    DynamicPolynomial<CoeffT, _dim - 1> s(
+        deg, Tags::Zero_Tag(), pool);
+    std::vector<CoeffT> factors(deg + 1);
+    factors[0] = CoeffTraits<CoeffT>::one();
+    for(int i = 1; i <= deg; i++) {
+      factors[i] = slice_pos * factors[i - 1];
+    }
+    Array<int, _dim - 1> buf;
+    coeff_iterator([&](const Array<int, _dim> &exponents,
+                       int i) {
+      for(int d = 0; d < slice_dim; d++) {
+        buf[d] = exponents[d];
+      }
+      for(int d = slice_dim + 1; d < _dim; d++) {
+        buf[d - 1] = exponents[d];
+      }
+      s.coeff(buf) +=
+          coeffs[i] * factors[exponents[slice_dim]];
+    });
+    return s;
+  }
+
+  template <
+      typename... subs_list,
+      typename std::enable_if<sizeof...(subs_list) == _dim,
+                              int>::type = 0>
+  CoeffT eval(subs_list... vars) const {
+    return eval(Array<CoeffT, _dim>(CoeffT(vars)...));
+  }
+
+  CoeffT eval(const Array<CoeffT, _dim> &point) const {
+    /* Tabulate the powers of each variable, then sum the
+     * terms in storage order */
+    std::vector<CoeffT> powers(_dim * (deg + 1));
+    for(int d = 0; d < _dim; d++) {
+      powers[d * (deg + 1)] = CoeffTraits<CoeffT>::one();
+      for(int e = 1; e <= deg; e++) {
+        powers[d * (deg + 1) + e] =
+            powers[d * (deg + 1) + e - 1] * point[d];
+      }
+    }
+    CoeffT sum = CoeffTraits<CoeffT>::zero();
+    coeff_iterator([&](const Array<int, _dim> &exponents,
+                       int i) {
+      CoeffT term = coeffs[i];
+      for(int d = 0; d < _dim; d++) {
+        term = term * powers[d * (deg + 1) + exponents[d]];
+      }
+      sum += term;
+    });
+    return sum;
+  }
+
+  template <typename, int>
+  friend class DynamicPolynomial;
+
+ private:
+  static int index(const Array<int, _dim> &exponents) {
+    return Utilities::term_index<_dim>(exponents);
+  }
+
+  template <typename Function>
+  void coeff_iterator(int cur_dim, int exp_left,
+                      Array<int, _dim> &exponents, int &idx,
+                      Function &function) const {
+    if(cur_dim == _dim - 1) {
+      exponents[cur_dim] = exp_left;
+      function(static_cast<const Array<int, _dim> &>(
+                   exponents),
+               idx++);
+      return;
+    }
+    for(exponents[cur_dim] = 0;
+        exponents[cur_dim] <= exp_left;
+        exponents[cur_dim]++) {
+      coeff_iterator(cur_dim + 1,
+                     exp_left - exponents[cur_dim],
+                     exponents, idx, function);
+    }
+  }
+
+  void allocate(int degree) {
+    assert(degree >= 0);
+    deg = degree;
+    size = Utilities::poly_num_coeffs(degree, _dim);
+    if(pool != nullptr) {
+      coeffs = pool->allocate(size);
+    } else {
+      coeffs = static_cast<CoeffT *>(
+          ::operator new(size * sizeof(CoeffT)));
+    }
+  }
+
+  void release() noexcept {
+    if(coeffs == nullptr) {
+      return;
+    }
+    for(int i = 0; i < size; i++) {
+      coeffs[i].~CoeffT();
+    }
+    if(pool != nullptr) {
+      pool->deallocate(coeffs, size);
+    } else {
+      ::operator delete(coeffs);
+    }
+    coeffs = nullptr;
+  }
+
+  Pool *pool;
+  CoeffT *coeffs;
+  int deg;
+  int size;
+};
+
+template <typename CoeffT, int _dim>
+DynamicPolynomial<CoeffT, _dim> operator+(
+    const CoeffT scalar,
+    const DynamicPolynomial<CoeffT, _dim> &p) {
+  return p + scalar;
+}
+
+template <typename CoeffT, int _dim>
+DynamicPolynomial<CoeffT, _dim> operator-(
+    const CoeffT scalar,
+    const DynamicPolynomial<CoeffT, _dim> &p) {
+  return -p + scalar;
+}
+
+template <typename CoeffT, int _dim>
+DynamicPolynomial<CoeffT, _dim> operator*(
+    const CoeffT scalar,
+    const DynamicPolynomial<CoeffT, _dim> &p) {
+  return p * scalar;
+}
+}  // namespace Numerical
+
+#endif  // _DYNAMIC_POLYNOMIAL_HPP_
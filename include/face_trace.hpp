@@ -0,0 +1,168 @@
+#ifndef _FACE_TRACE_HPP_
+#define _FACE_TRACE_HPP_
+
+#include <affine_map.hpp>
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial_batch.hpp>
+
+#include <cassert>
+#include <vector>
+
+namespace Numerical {
+
+namespace Internal {
+
+/* The number of coordinates on a face of a _dim element.
+ * The faces of a 1D element are points, whose traces are
+ * the polynomials' values there; a 0 variable polynomial
+ * batch can't hold them, so take them with eval instead */
+template <int _dim>
+struct FaceDim {
+  static_assert(_dim >= 2,
+                "Face traces need at least 2 dimensions; "
+                "evaluate 1D polynomials at the end points "
+                "instead");
+  /* Kept valid so the assertion is the only error */
+  static constexpr const int value =
+      _dim >= 2 ? _dim - 1 : 1;
+};
+}  // namespace Internal
+
+/* Restricts polynomials of _dim >= 2 variables to a face,
+ * giving polynomials of the face's _dim - 1 coordinates */
+template <typename CoeffT, int _degree, int _dim>
+using FaceTrace =
+    AffineMap<CoeffT, _degree, _dim,
+              Internal::FaceDim<_dim>::value>;
+
+/* The trace on the face x_variable = pos; the face's
+ * coordinates are the remaining variables in order, so the
+ * trace of p is p.slice(variable, pos) */
+template <typename CoeffT, int _degree, int _dim>
+FaceTrace<CoeffT, _degree, _dim> axis_face_trace(
+    int variable, const CoeffT &pos) {
+  assert(variable >= 0);
+  assert(variable < _dim);
+  typename FaceTrace<CoeffT, _degree, _dim>::Matrix A;
+  Array<CoeffT, _dim> b;
+  for(int i = 0; i < _dim; i++) {
+    for(int j = 0; j < _dim - 1; j++) {
+      const int var = j < variable ? j : j + 1;
+      A[i][j] =
+          CoeffTraits<CoeffT>::broadcast(int(i == var));
+    }
+    b[i] = i == variable ? pos
+                         : CoeffTraits<CoeffT>::zero();
+  }
+  return FaceTrace<CoeffT, _degree, _dim>(A, b);
+}
+
+/* The trace on the simplex face with the vertices; the
+ * face's coordinates s map to
+ * v_0 + s_0 (v_1 - v_0) + s_1 (v_2 - v_0) + ...,
+ * ie. they're the coordinates on the reference simplex of
+ * one less dimension */
+template <typename CoeffT, int _degree, int _dim>
+FaceTrace<CoeffT, _degree, _dim> simplex_face_trace(
+    const Array<Array<CoeffT, _dim>, _dim> &vertices) {
+  typename FaceTrace<CoeffT, _degree, _dim>::Matrix A;
+  for(int i = 0; i < _dim; i++) {
+    for(int j = 0; j < _dim - 1; j++) {
+      A[i][j] = vertices[j + 1][i] - vertices[0][i];
+    }
+  }
+  return FaceTrace<CoeffT, _degree, _dim>(A, vertices[0]);
+}
+
+/* The traces on the faces of the reference cube
+ * [0, 1]^_dim; face 2 d + s is x_d = s.
+ * They're built on the first call and cached */
+template <typename CoeffT, int _degree, int _dim>
+const std::vector<FaceTrace<CoeffT, _degree, _dim> > &
+cube_face_traces() {
+  using Trace = FaceTrace<CoeffT, _degree, _dim>;
+  static const std::vector<Trace> traces = [] {
+    std::vector<Trace> faces;
+    for(int d = 0; d < _dim; d++) {
+      for(int s = 0; s < 2; s++) {
+        faces.push_back(
+            axis_face_trace<CoeffT, _degree, _dim>(
+                d, CoeffTraits<CoeffT>::broadcast(s)));
+      }
+    }
+    return faces;
+  }();
+  return traces;
+}
+
+/* The traces on the faces of the reference simplex with
+ * the vertices 0, e_0, e_1, ...; face i is opposite vertex
+ * i, and its vertices are the others in order.
+ * They're built on the first call and cached */
+template <typename CoeffT, int _degree, int _dim>
+const std::vector<FaceTrace<CoeffT, _degree, _dim> > &
+simplex_face_traces() {
+  using Trace = FaceTrace<CoeffT, _degree, _dim>;
+  static const std::vector<Trace> traces = [] {
+    Array<Array<CoeffT, _dim>, _dim + 1> reference;
+    for(int v = 0; v <= _dim; v++) {
+      for(int d = 0; d < _dim; d++) {
+        reference[v][d] =
+            CoeffTraits<CoeffT>::broadcast(int(v == d + 1));
+      }
+    }
+    std::vector<Trace> faces;
+    for(int opposite = 0; opposite <= _dim; opposite++) {
+      Array<Array<CoeffT, _dim>, _dim> vertices;
+      for(int v = 0, f = 0; v <= _dim; v++) {
+        if(v != opposite) {
+          vertices[f++] = reference[v];
+        }
+      }
+      faces.push_back(
+          simplex_face_trace<CoeffT, _degree, _dim>(
+              vertices));
+    }
+    return faces;
+  }();
+  return traces;
+}
+
+/* Computes the trace of every polynomial of the batch on
+ * every face in one pass over the batch's coefficients;
+ * the trace on faces[f] is written to traces[f] */
+template <typename CoeffT, int _degree, int _dim>
+void face_traces(
+    const std::vector<FaceTrace<CoeffT, _degree, _dim> >
+        &faces,
+    const PolynomialBatch<CoeffT, _degree, _dim> &polys,
+    std::vector<PolynomialBatch<CoeffT, _degree, _dim - 1> >
+        &traces) {
+  using Trace = FaceTrace<CoeffT, _degree, _dim>;
+  const int count = polys.size();
+  traces.assign(faces.size(),
+                PolynomialBatch<CoeffT, _degree, _dim - 1>(
+                    count, Tags::Zero_Tag()));
+  for(int k = 0; k < Trace::num_coeffs; k++) {
+    const CoeffT *src = polys.coeffs(k);
+    const int rows = Utilities::poly_num_coeffs(
+        Utilities::basis_degree(k, _dim), _dim - 1);
+    for(int f = 0; f < int(faces.size()); f++) {
+      const CoeffT *col = faces[f].column(k);
+      for(int i = 0; i < rows; i++) {
+        if(CoeffTraits<CoeffT>::is_zero(col[i])) {
+          continue;
+        }
+        CoeffT *dest = traces[f].coeffs(i);
+        for(int p = 0; p < count; p++) {
+          dest[p] = CoeffTraits<CoeffT>::fma(
+              src[p], col[i], dest[p]);
+        }
+      }
+    }
+  }
+}
+}  // namespace Numerical
+
+#endif  // _FACE_TRACE_HPP_
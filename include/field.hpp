@@ -4,14 +4,39 @@
 
 namespace Numerical {
 
-class FieldType {
- public:
-  constexpr static const FieldType &addId();
-  constexpr static const FieldType &multiplyId();
-  FieldType operator+(const FieldType) const;
-	FieldType operator-() const;
-  FieldType operator*(const FieldType) const;
+/* The operations Polynomial needs from its coefficient
+ * type.
+ * CoeffT must be copyable and provide +, unary and binary
+ * -, *, / and their compound assignments, == and
+ * construction from an int; everything else goes through
+ * these traits, which a coefficient type may specialize
+ * for a faster or more accurate version.
+ */
+template <typename CoeffT>
+struct CoeffTraits {
+  /* The additive identity */
+  static CoeffT zero() noexcept { return CoeffT(0); }
+
+  /* The multiplicative identity */
+  static CoeffT one() noexcept { return CoeffT(1); }
+
+  /* Returns a * b + c */
+  static CoeffT fma(const CoeffT &a, const CoeffT &b,
+                    const CoeffT &c) noexcept {
+    return a * b + c;
+  }
+
+  /* Converts a scalar to the coefficient type, filling
+   * every lane of vector types */
+  template <typename ScalarT>
+  static CoeffT broadcast(const ScalarT &s) noexcept {
+    return CoeffT(s);
+  }
+
+  static bool is_zero(const CoeffT &c) noexcept {
+    return c == zero();
+  }
 };
-}
+}  // namespace Numerical
 
 #endif  // _FIELD_HPP_
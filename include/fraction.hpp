@@ -1,60 +1,310 @@
-
 #ifndef _FRACTION_HPP_
 #define _FRACTION_HPP_
 
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
 namespace Numerical {
 
+/* An exact rational number, always kept in lowest terms
+ * with a positive denominator.
+ * The numerator and denominator are 64 bit integers;
+ * arithmetic is done in 64 bits when it can't overflow,
+ * and otherwise in 128 bits before reducing. Results which
+ * don't fit in 64 bits after reducing throw
+ * std::overflow_error.
+ */
 class Fraction {
  public:
-  Fraction(int num, int den) {
-    this->num = num;
-    this->den = den;
+  using int_t = std::int64_t;
+
+  constexpr Fraction() noexcept : num(0), den(1) {}
+
+  template <typename Int,
+            typename std::enable_if<
+                std::is_integral<Int>::value,
+                int>::type = 0>
+  constexpr Fraction(Int val) noexcept
+      : num(int_t(val)), den(1) {}
+
+  Fraction(int_t num, int_t den) : num(num), den(den) {
+    normalize();
+  }
+
+  bool isValid() const { return den != 0; }
+
+  int_t numerator() const noexcept { return num; }
+
+  int_t denominator() const noexcept { return den; }
+
+  explicit operator double() const noexcept {
+    return double(num) / double(den);
+  }
+
+  explicit operator long double() const noexcept {
+    return static_cast<long double>(num) /
+           static_cast<long double>(den);
+  }
+
+  Fraction operator-() const {
+    if(num == INT64_MIN) {
+      throw std::overflow_error(
+          "Fraction negation overflow");
+    }
+    return raw(-num, den);
+  }
+
+  friend Fraction operator+(const Fraction &lhs,
+                            const Fraction &rhs) {
+    return add(lhs, rhs.num, rhs.den);
+  }
+
+  friend Fraction operator-(const Fraction &lhs,
+                            const Fraction &rhs) {
+    return lhs + (-rhs);
+  }
+
+  friend Fraction operator*(const Fraction &lhs,
+                            const Fraction &rhs) {
+    return multiply(lhs.num, lhs.den, rhs.num, rhs.den);
+  }
+
+  friend Fraction operator/(const Fraction &lhs,
+                            const Fraction &rhs) {
+    assert(rhs.num != 0);
+    if(rhs.num < 0) {
+      return multiply(lhs.num, lhs.den, -int128(rhs.den),
+                      -int128(rhs.num));
+    }
+    return multiply(lhs.num, lhs.den, rhs.den, rhs.num);
+  }
+
+  Fraction &operator+=(const Fraction &val) {
+    return *this = *this + val;
+  }
+
+  Fraction &operator-=(const Fraction &val) {
+    return *this = *this - val;
   }
 
-	bool isValid() const {
-		return den != 0;
-	}
+  Fraction &operator*=(const Fraction &val) {
+    return *this = *this * val;
+  }
+
+  Fraction &operator/=(const Fraction &val) {
+    return *this = *this / val;
+  }
 
-  Fraction operator+(int val) const {
-    return Fraction(val * this->den + this->num, this->den);
+  /* Both are in lowest terms, so equal fractions have equal
+   * numerators and denominators */
+  friend bool operator==(const Fraction &lhs,
+                         const Fraction &rhs) noexcept {
+    return lhs.num == rhs.num && lhs.den == rhs.den;
   }
 
-  Fraction operator-(int val) const {
-    return Fraction(-val * this->den + this->num,
-                    this->den);
+  friend bool operator!=(const Fraction &lhs,
+                         const Fraction &rhs) noexcept {
+    return !(lhs == rhs);
   }
 
-  Fraction operator*(int val) const {
-    return Fraction(val * this->num, this->den);
+  friend bool operator<(const Fraction &lhs,
+                        const Fraction &rhs) noexcept {
+    /* The denominators are positive, and the cross products
+     * always fit in 128 bits */
+    return int128(lhs.num) * rhs.den <
+           int128(rhs.num) * lhs.den;
   }
 
-  Fraction operator/(int val) const {
-    return Fraction(this->num, val * this->den);
+  friend bool operator>(const Fraction &lhs,
+                        const Fraction &rhs) noexcept {
+    return rhs < lhs;
   }
 
-  Fraction operator+=(int val) {
-    this->num += val * this->den;
-    return *this;
+  friend bool operator<=(const Fraction &lhs,
+                         const Fraction &rhs) noexcept {
+    return !(rhs < lhs);
   }
 
-  Fraction operator-=(int val) {
-    this->num -= val * this->den;
-    return *this;
+  friend bool operator>=(const Fraction &lhs,
+                         const Fraction &rhs) noexcept {
+    return !(lhs < rhs);
   }
 
-  Fraction operator*=(int val) {
-    this->num *= val;
-    return *this;
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const Fraction &f) {
+    os << f.num;
+    if(f.den != 1) {
+      os << "/" << f.den;
+    }
+    return os;
   }
 
-  Fraction operator/=(int val) {
-    this->den *= val;
-    return *this;
+  /* Stein's binary GCD; gcd(0, 0) is 0 */
+  static std::uint64_t gcd(std::uint64_t u,
+                           std::uint64_t v) noexcept {
+    if(u == 0) {
+      return v;
+    }
+    if(v == 0) {
+      return u;
+    }
+    const int shift = __builtin_ctzll(u | v);
+    u >>= __builtin_ctzll(u);
+    do {
+      v >>= __builtin_ctzll(v);
+      if(u > v) {
+        const std::uint64_t t = v;
+        v = u;
+        u = t;
+      }
+      v -= u;
+    } while(v != 0);
+    return u << shift;
   }
 
  private:
-  int num, den;
+  using int128 = __int128;
+  using uint128 = unsigned __int128;
+
+  static Fraction raw(int_t num, int_t den) noexcept {
+    Fraction f;
+    f.num = num;
+    f.den = den;
+    return f;
+  }
+
+  static std::uint64_t magnitude(int_t v) noexcept {
+    return v < 0 ? std::uint64_t(0) - std::uint64_t(v)
+                 : std::uint64_t(v);
+  }
+
+  static int ctz128(uint128 v) noexcept {
+    const std::uint64_t low = std::uint64_t(v);
+    if(low != 0) {
+      return __builtin_ctzll(low);
+    }
+    return 64 + __builtin_ctzll(std::uint64_t(v >> 64));
+  }
+
+  static uint128 gcd128(uint128 u, uint128 v) noexcept {
+    if(u == 0) {
+      return v;
+    }
+    if(v == 0) {
+      return u;
+    }
+    const int shift = ctz128(u | v);
+    u >>= ctz128(u);
+    do {
+      v >>= ctz128(v);
+      if(u > v) {
+        const uint128 t = v;
+        v = u;
+        u = t;
+      }
+      v -= u;
+    } while(v != 0);
+    return u << shift;
+  }
+
+  void normalize() {
+    if(den == 0) {
+      return;
+    }
+    if(den < 0) {
+      *this = reduce(-int128(num), -int128(den));
+      return;
+    }
+    const std::uint64_t g = gcd(magnitude(num), den);
+    if(g > 1) {
+      num /= int_t(g);
+      den /= int_t(g);
+    }
+  }
+
+  /* Reduces num / den (den > 0) computed in 128 bits */
+  static Fraction reduce(int128 num, int128 den) {
+    assert(den > 0);
+    const uint128 mag = num < 0 ? uint128(0) - uint128(num)
+                                : uint128(num);
+    const uint128 g = gcd128(mag, uint128(den));
+    if(g > 1) {
+      num /= int128(g);
+      den /= int128(g);
+    }
+    if(num < INT64_MIN || num > INT64_MAX ||
+       den > INT64_MAX) {
+      throw std::overflow_error(
+          "Fraction doesn't fit in 64 bits");
+    }
+    return raw(int_t(num), int_t(den));
+  }
+
+  static Fraction add(const Fraction &lhs, int_t c,
+                      int_t d) {
+    const int_t a = lhs.num, b = lhs.den;
+    /* With g = gcd(b, d), the sum is
+     * (a (d / g) + c (b / g)) / (b (d / g))
+     * and any common factor of the result divides g */
+    const int_t g = int_t(gcd(std::uint64_t(b),
+                              std::uint64_t(d)));
+    const int_t bg = b / g, dg = d / g;
+    int_t ad, cb, n, m;
+    if(!__builtin_mul_overflow(a, dg, &ad) &&
+       !__builtin_mul_overflow(c, bg, &cb) &&
+       !__builtin_add_overflow(ad, cb, &n) &&
+       !__builtin_mul_overflow(b, dg, &m)) {
+      const int_t g2 = int_t(gcd(magnitude(n), g));
+      if(g2 > 1) {
+        n /= g2;
+        m /= g2;
+      }
+      return raw(n, m);
+    }
+    return reduce(int128(a) * dg + int128(c) * bg,
+                  int128(b) * dg);
+  }
+
+  /* (a / b) (c / d), with b, d > 0 */
+  static Fraction multiply(int128 a, int128 b, int128 c,
+                           int128 d) {
+    if(a >= INT64_MIN && a <= INT64_MAX &&
+       b <= INT64_MAX && c >= INT64_MIN &&
+       c <= INT64_MAX && d <= INT64_MAX) {
+      /* Cross cancel first so the product is already in
+       * lowest terms */
+      int_t an = int_t(a), bd = int_t(b), cn = int_t(c),
+            dd = int_t(d);
+      const int_t g1 =
+          int_t(gcd(magnitude(an), std::uint64_t(dd)));
+      const int_t g2 =
+          int_t(gcd(magnitude(cn), std::uint64_t(bd)));
+      if(g1 > 1) {
+        an /= g1;
+        dd /= g1;
+      }
+      if(g2 > 1) {
+        cn /= g2;
+        bd /= g2;
+      }
+      int_t n, m;
+      if(!__builtin_mul_overflow(an, cn, &n) &&
+         !__builtin_mul_overflow(bd, dd, &m)) {
+        return raw(n, m);
+      }
+      a = an;
+      b = bd;
+      c = cn;
+      d = dd;
+    }
+    return reduce(a * c, b * d);
+  }
+
+  int_t num, den;
 };
-}
+}  // namespace Numerical
 
 #endif  //_FRACTION_HPP_
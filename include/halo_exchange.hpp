@@ -0,0 +1,127 @@
+#ifndef _HALO_EXCHANGE_HPP_
+#define _HALO_EXCHANGE_HPP_
+
+#include <partition.hpp>
+
+#include <mpi.h>
+
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace Numerical {
+namespace Parallel {
+
+/* Non-blocking exchange of the ghost elements described by
+ * a CartesianPartition.
+ * Elements are sent as raw bytes, so ElemT must be
+ * trivially copyable, ie. a Polynomial of a plain
+ * coefficient type.
+ * Ghosts are received directly into the element storage,
+ * and send lists which are contiguous in the storage are
+ * sent from it without packing.
+ */
+template <typename ElemT, int dim>
+class HaloExchange {
+  static_assert(std::is_trivially_copyable<ElemT>::value,
+                "Halo elements are sent as raw bytes");
+
+ public:
+  HaloExchange(const CartesianPartition<dim> &part,
+               MPI_Comm comm = MPI_COMM_WORLD,
+               int tag = 1337)
+      : part(part), comm(comm), tag(tag), active(false) {
+    MPI_Type_contiguous(int(sizeof(ElemT)), MPI_BYTE,
+                        &elem_type);
+    MPI_Type_commit(&elem_type);
+    const auto &nbrs = part.neighbors();
+    send_bufs.resize(nbrs.size());
+    for(int i = 0; i < int(nbrs.size()); i++) {
+      if(!nbrs[i].send_contiguous) {
+        send_bufs[i].resize(nbrs[i].send.size());
+      }
+    }
+    requests.reserve(2 * nbrs.size());
+  }
+
+  HaloExchange(const HaloExchange &) = delete;
+  HaloExchange &operator=(const HaloExchange &) = delete;
+
+  ~HaloExchange() {
+    if(active) {
+      finish();
+    }
+    MPI_Type_free(&elem_type);
+  }
+
+  /* Posts the receives for the ghosts and the sends of the
+   * boundary elements; elems must not be modified or
+   * destroyed before finish() returns */
+  void begin(std::vector<ElemT> &elems) {
+    assert(!active);
+    assert(int(elems.size()) == part.num_local());
+    const auto &nbrs = part.neighbors();
+    requests.clear();
+    for(const auto &n : nbrs) {
+      if(n.recv_count > 0) {
+        requests.emplace_back();
+        MPI_Irecv(elems.data() + n.recv_offset,
+                  n.recv_count, elem_type, n.rank, tag,
+                  comm, &requests.back());
+      }
+    }
+    for(int i = 0; i < int(nbrs.size()); i++) {
+      const auto &n = nbrs[i];
+      if(n.send.empty()) {
+        continue;
+      }
+      const ElemT *src;
+      if(n.send_contiguous) {
+        src = elems.data() + n.send.front();
+      } else {
+        for(int j = 0; j < int(n.send.size()); j++) {
+          std::memcpy(&send_bufs[i][j], &elems[n.send[j]],
+                      sizeof(ElemT));
+        }
+        src = send_bufs[i].data();
+      }
+      requests.emplace_back();
+      MPI_Isend(src, int(n.send.size()), elem_type, n.rank,
+                tag, comm, &requests.back());
+    }
+    active = true;
+  }
+
+  void finish() {
+    assert(active);
+    MPI_Waitall(int(requests.size()), requests.data(),
+                MPI_STATUSES_IGNORE);
+    active = false;
+  }
+
+  /* Exchanges the halo while interior(lo, hi) runs over the
+   * interior elements, then runs boundary(lo, hi) over the
+   * owned elements which depend on the ghosts */
+  template <typename Interior, typename Boundary>
+  void overlap(std::vector<ElemT> &elems,
+               Interior &&interior, Boundary &&boundary) {
+    begin(elems);
+    interior(0, part.num_interior());
+    finish();
+    boundary(part.num_interior(), part.num_owned());
+  }
+
+ private:
+  const CartesianPartition<dim> &part;
+  MPI_Comm comm;
+  int tag;
+  bool active;
+  MPI_Datatype elem_type;
+  std::vector<std::vector<ElemT> > send_bufs;
+  std::vector<MPI_Request> requests;
+};
+}  // namespace Parallel
+}  // namespace Numerical
+
+#endif  // _HALO_EXCHANGE_HPP_
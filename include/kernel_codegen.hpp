@@ -0,0 +1,319 @@
+#ifndef _KERNEL_CODEGEN_HPP_
+#define _KERNEL_CODEGEN_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+namespace IO {
+
+namespace Internal {
+
+/* A double literal which round trips; infinities and NaNs
+ * have no literal, so they throw std::domain_error */
+inline std::string double_literal(double v) {
+  if(!std::isfinite(v)) {
+    throw std::domain_error(
+        "Kernel coefficients must be finite");
+  }
+  std::ostringstream s;
+  s << std::setprecision(
+           std::numeric_limits<double>::max_digits10)
+    << v;
+  std::string lit = s.str();
+  if(lit.find_first_of(".en") == std::string::npos) {
+    lit += ".0";
+  }
+  return lit;
+}
+
+/* name with every character which can't appear in a C++
+ * identifier replaced by '_', and '_' prefixed to a
+ * leading digit, so names differing only there stay
+ * distinct */
+inline std::string identifier(const std::string &name) {
+  std::string id = name.empty() ? "_" : name;
+  for(char &c : id) {
+    if(!std::isalnum(static_cast<unsigned char>(c))) {
+      c = '_';
+    }
+  }
+  if(std::isdigit(static_cast<unsigned char>(id[0]))) {
+    id.insert(0, 1, '_');
+  }
+  return id;
+}
+
+template <int _dim>
+std::string monomial_name(const Array<int, _dim> &e) {
+  std::string name = "m";
+  for(int d = 0; d < _dim; d++) {
+    name += "_" + std::to_string(e[d]);
+  }
+  return name;
+}
+
+/* The sum of coefficient * monomial terms, with zero terms
+ * dropped and unit coefficients folded into the monomial;
+ * an empty monomial name is the constant 1 */
+inline std::string linear_combination(
+    const std::vector<std::pair<double, std::string> >
+        &terms) {
+  std::string expr;
+  for(const auto &term : terms) {
+    double c = term.first;
+    if(c == 0.0) {
+      continue;
+    }
+    if(expr.empty()) {
+      if(c < 0.0) {
+        expr = "-";
+        c = -c;
+      }
+    } else {
+      expr += c < 0.0 ? " - " : " + ";
+      c = std::abs(c);
+    }
+    if(term.second.empty()) {
+      expr += double_literal(c);
+    } else if(c == 1.0) {
+      expr += term.second;
+    } else {
+      expr += double_literal(c) + " * " + term.second;
+    }
+  }
+  return expr.empty() ? "0.0" : expr;
+}
+
+/* Writes the monomials needed[k] marks, and the ones
+ * they're built from, each with one multiply by its
+ * parent: the monomial with the first nonzero exponent
+ * decremented */
+template <int _dim>
+void write_monomials(
+    std::ostream &out,
+    const std::vector<Array<int, _dim> > &terms,
+    std::vector<bool> needed) {
+  for(int k = int(terms.size()) - 1; k > 0; k--) {
+    if(!needed[k]) {
+      continue;
+    }
+    Array<int, _dim> parent(terms[k]);
+    for(int d = 0; d < _dim; d++) {
+      if(parent[d] > 0) {
+        parent[d]--;
+        break;
+      }
+    }
+    needed[Utilities::term_index(parent)] = true;
+  }
+  for(int k = 1; k < int(terms.size()); k++) {
+    if(!needed[k]) {
+      continue;
+    }
+    Array<int, _dim> parent(terms[k]);
+    int var = 0;
+    while(parent[var] == 0) {
+      var++;
+    }
+    parent[var]--;
+    out << "  const double " << monomial_name(terms[k])
+        << " = ";
+    if(Utilities::term_index(parent) == 0) {
+      out << "x[" << var << "];\n";
+    } else {
+      out << monomial_name(parent) << " * x[" << var
+          << "];\n";
+    }
+  }
+}
+}  // namespace Internal
+
+/* Writes a header with straight-line kernels for the fixed
+ * polynomials in functions, in the namespace name (made a
+ * valid identifier with Internal::identifier):
+ *   eval(x, values) sets values[f] to functions[f](x),
+ *   eval_with_gradient(x, values, gradients) also sets
+ *   gradients[f * dim + v] to d functions[f] / d x_v,
+ *   and tabulate and tabulate_with_gradient do the same
+ *   for num_points points, num_functions values apart.
+ * Each monomial is computed once with one multiply and
+ * shared by every function, zero terms are dropped, and
+ * the derivatives' exponent factors are folded into their
+ * coefficients.
+ * The coefficients are written in double precision; if
+ * any aren't finite, std::domain_error is thrown before
+ * anything is written.
+ */
+template <typename CoeffT, int _degree, int _dim>
+void write_kernel_header(
+    std::ostream &out, const std::string &ns,
+    const std::vector<Polynomial<CoeffT, _degree, _dim> >
+        &functions) {
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  const std::string name = Internal::identifier(ns);
+  const std::vector<Array<int, _dim> > terms =
+      Utilities::term_exponents<_dim>(_degree);
+  const int num_functions = int(functions.size());
+  /* Runs of '_' are collapsed, and the prefix keeps it
+   * from starting with '_', so the guard can't be a
+   * reserved identifier */
+  std::string guard = "KERNEL_";
+  for(char c : name) {
+    if(c != '_' || guard.back() != '_') {
+      guard += std::toupper(static_cast<unsigned char>(c));
+    }
+  }
+  guard += guard.back() == '_' ? "HPP_" : "_HPP_";
+
+  auto coeff = [&](int f, int k) {
+    return static_cast<double>(functions[f].data()[k]);
+  };
+  /* The terms of function f, or of its derivative by var
+   * when var >= 0 */
+  auto function_terms = [&](int f, int var) {
+    std::vector<std::pair<double, std::string> > sum;
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      if(var < 0) {
+        sum.emplace_back(coeff(f, k),
+                         k == 0 ? std::string()
+                                : Internal::monomial_name(
+                                      terms[k]));
+      } else if(terms[k][var] > 0) {
+        Array<int, _dim> lowered(terms[k]);
+        lowered[var]--;
+        sum.emplace_back(
+            coeff(f, k) * terms[k][var],
+            Utilities::term_index(lowered) == 0
+                ? std::string()
+                : Internal::monomial_name(lowered));
+      }
+    }
+    return sum;
+  };
+  /* Rejects non-finite coefficients before anything is
+   * written */
+  for(int f = 0; f < num_functions; f++) {
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      Internal::double_literal(coeff(f, k));
+    }
+  }
+  std::vector<bool> value_terms(Poly::num_coeffs, false);
+  std::vector<bool> gradient_terms(Poly::num_coeffs, false);
+  for(int f = 0; f < num_functions; f++) {
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      if(coeff(f, k) == 0.0) {
+        continue;
+      }
+      value_terms[k] = true;
+      gradient_terms[k] = true;
+      for(int v = 0; v < _dim; v++) {
+        if(terms[k][v] > 0) {
+          Array<int, _dim> lowered(terms[k]);
+          lowered[v]--;
+          gradient_terms[Utilities::term_index(lowered)] =
+              true;
+        }
+      }
+    }
+  }
+
+  out << "/* Generated by write_kernel_header; don't "
+         "edit */\n\n#ifndef "
+      << guard << "\n#define " << guard
+      << "\n\nnamespace " << name << " {\n\n"
+      << "constexpr const int dim = " << _dim << ";\n"
+      << "constexpr const int degree = " << _degree
+      << ";\n"
+      << "constexpr const int num_functions = "
+      << num_functions << ";\n"
+      << "constexpr const int num_coeffs = "
+      << Poly::num_coeffs << ";\n\n"
+      << "/* The coefficients of each function in "
+         "Polynomial's storage order */\n"
+      << "constexpr const double "
+         "coefficients[num_functions][num_coeffs] = {\n";
+  for(int f = 0; f < num_functions; f++) {
+    out << "    {";
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      out << (k > 0 ? ", " : "")
+          << Internal::double_literal(coeff(f, k));
+    }
+    out << "},\n";
+  }
+  out << "};\n\n";
+
+  out << "inline void eval(const double *x, "
+         "double *values) noexcept {\n";
+  Internal::write_monomials(out, terms, value_terms);
+  for(int f = 0; f < num_functions; f++) {
+    out << "  values[" << f << "] = "
+        << Internal::linear_combination(
+               function_terms(f, -1))
+        << ";\n";
+  }
+  out << "}\n\n";
+
+  out << "inline void eval_with_gradient(const double *x, "
+         "double *values,\n"
+      << "                               "
+         "double *gradients) noexcept {\n";
+  Internal::write_monomials(out, terms, gradient_terms);
+  for(int f = 0; f < num_functions; f++) {
+    out << "  values[" << f << "] = "
+        << Internal::linear_combination(
+               function_terms(f, -1))
+        << ";\n";
+    for(int v = 0; v < _dim; v++) {
+      out << "  gradients[" << f * _dim + v << "] = "
+          << Internal::linear_combination(
+                 function_terms(f, v))
+          << ";\n";
+    }
+  }
+  out << "}\n\n";
+
+  out << "inline void tabulate(const double *points, int "
+         "num_points,\n"
+      << "                     double *values) noexcept {\n"
+      << "  for(int p = 0; p < num_points; p++) {\n"
+      << "    eval(points + p * dim, values + p * "
+         "num_functions);\n"
+      << "  }\n"
+      << "}\n\n";
+
+  out << "inline void tabulate_with_gradient(const double "
+         "*points,\n"
+      << "                                   "
+         "int num_points, double *values,\n"
+      << "                                   double "
+         "*gradients) noexcept {\n"
+      << "  for(int p = 0; p < num_points; p++) {\n"
+      << "    eval_with_gradient(points + p * dim,\n"
+      << "                       values + p * "
+         "num_functions,\n"
+      << "                       gradients + p * "
+         "num_functions * dim);\n"
+      << "  }\n"
+      << "}\n\n";
+
+  out << "}  // namespace " << name << "\n\n#endif  // "
+      << guard << "\n";
+}
+}  // namespace IO
+}  // namespace Numerical
+
+#endif  // _KERNEL_CODEGEN_HPP_
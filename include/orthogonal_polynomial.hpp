@@ -0,0 +1,438 @@
+#ifndef _ORTHOGONAL_POLYNOMIAL_HPP_
+#define _ORTHOGONAL_POLYNOMIAL_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+#include <tags.hpp>
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+/* The families of orthogonal polynomials on [-1, 1] that
+ * OrthogonalPolynomial can use. Each is defined by its
+ * three term recurrence, with P_0 = 1, P_-1 = 0 and
+ * P_(n + 1) = alpha(n) x P_n - gamma(n) P_(n - 1),
+ * and provides the recurrences for the coefficients of
+ * derivatives and antiderivatives in the family.
+ */
+template <typename CoeffT>
+struct Chebyshev {
+  static CoeffT alpha(int n) noexcept {
+    return CoeffTraits<CoeffT>::broadcast(n == 0 ? 1 : 2);
+  }
+
+  static CoeffT gamma(int) noexcept {
+    return CoeffTraits<CoeffT>::one();
+  }
+
+  /* The derivative's coefficients d of the series with
+   * coefficients c satisfy
+   * d_(k - 1) = derivative_carry(k) d_(k + 1) +
+   *             derivative_weight(k) c_k,
+   * after which d_0 is scaled by derivative_first_scale */
+  static CoeffT derivative_carry(int) noexcept {
+    return CoeffTraits<CoeffT>::one();
+  }
+
+  static CoeffT derivative_weight(int k) noexcept {
+    return CoeffTraits<CoeffT>::broadcast(2 * k);
+  }
+
+  static CoeffT derivative_first_scale() noexcept {
+    return CoeffTraits<CoeffT>::one() /
+           CoeffTraits<CoeffT>::broadcast(2);
+  }
+
+  /* The integral of T_k is
+   * first T_(k + 1) - second T_(k - 1) + a constant */
+  static std::pair<CoeffT, CoeffT> integral(
+      int k) noexcept {
+    const CoeffT one = CoeffTraits<CoeffT>::one();
+    if(k == 0) {
+      return std::make_pair(one,
+                            CoeffTraits<CoeffT>::zero());
+    } else if(k == 1) {
+      const CoeffT q =
+          one / CoeffTraits<CoeffT>::broadcast(4);
+      return std::make_pair(q, -q);
+    }
+    return std::make_pair(
+        one / CoeffTraits<CoeffT>::broadcast(2 * (k + 1)),
+        one / CoeffTraits<CoeffT>::broadcast(2 * (k - 1)));
+  }
+};
+
+template <typename CoeffT>
+struct Legendre {
+  static CoeffT alpha(int n) noexcept {
+    return CoeffTraits<CoeffT>::broadcast(2 * n + 1) /
+           CoeffTraits<CoeffT>::broadcast(n + 1);
+  }
+
+  static CoeffT gamma(int n) noexcept {
+    return CoeffTraits<CoeffT>::broadcast(n) /
+           CoeffTraits<CoeffT>::broadcast(n + 1);
+  }
+
+  static CoeffT derivative_carry(int k) noexcept {
+    return CoeffTraits<CoeffT>::broadcast(2 * k - 1) /
+           CoeffTraits<CoeffT>::broadcast(2 * k + 3);
+  }
+
+  static CoeffT derivative_weight(int k) noexcept {
+    return CoeffTraits<CoeffT>::broadcast(2 * k - 1);
+  }
+
+  static CoeffT derivative_first_scale() noexcept {
+    return CoeffTraits<CoeffT>::one();
+  }
+
+  static std::pair<CoeffT, CoeffT> integral(
+      int k) noexcept {
+    const CoeffT one = CoeffTraits<CoeffT>::one();
+    if(k == 0) {
+      return std::make_pair(one,
+                            CoeffTraits<CoeffT>::zero());
+    }
+    const CoeffT w =
+        one / CoeffTraits<CoeffT>::broadcast(2 * k + 1);
+    return std::make_pair(w, w);
+  }
+};
+
+/* A polynomial of total degree _degree in the product
+ * basis P_e0(x_0) P_e1(x_1) ... of a family of orthogonal
+ * polynomials.
+ * Coefficients are stored in the same order as Polynomial
+ * stores its monomial coefficients, and every operation
+ * works one variable at a time, since the 1D basis changes
+ * don't raise the total degree of a term.
+ * Evaluation uses Clenshaw's recurrence, which is stable
+ * and visits each coefficient once.
+ */
+template <typename CoeffT, int _degree, int _dim,
+          template <typename> class Family>
+class OrthogonalPolynomial {
+ public:
+  static constexpr const int dim = _dim;
+  static constexpr const int degree = _degree;
+  static constexpr const int num_coeffs =
+      Polynomial<CoeffT, _degree, _dim>::num_coeffs;
+  using Basis = Family<CoeffT>;
+
+  static_assert(_dim > 0,
+                "An orthogonal polynomial needs at least "
+                "one variable");
+
+  OrthogonalPolynomial() {}
+
+  OrthogonalPolynomial(const Tags::Zero_Tag &)
+      : coeffs(Tags::Zero_Tag()) {}
+
+  /* x^n is expanded in the family with
+   * x P_j = (P_(j + 1) + gamma(j) P_(j - 1)) / alpha(j) */
+  explicit OrthogonalPolynomial(
+      const Polynomial<CoeffT, _degree, _dim> &p)
+      : coeffs(Tags::Zero_Tag()) {
+    Matrix M = zero_matrix();
+    M[0][0] = CoeffTraits<CoeffT>::one();
+    for(int n = 0; n < _degree; n++) {
+      for(int j = 0; j <= n; j++) {
+        const CoeffT c = M[j][n] / Basis::alpha(j);
+        M[j + 1][n + 1] = M[j + 1][n + 1] + c;
+        if(j > 0) {
+          M[j - 1][n + 1] =
+              CoeffTraits<CoeffT>::fma(c, Basis::gamma(j),
+                                       M[j - 1][n + 1]);
+        }
+      }
+    }
+    for(int i = 0; i < num_coeffs; i++) {
+      coeffs[i] = p.data()[i];
+    }
+    for(int d = 0; d < _dim; d++) {
+      apply_axis(M, d);
+    }
+  }
+
+  /* The monomial coefficients of P_n come from the
+   * recurrence */
+  Polynomial<CoeffT, _degree, _dim> to_monomial() const {
+    Matrix M = zero_matrix();
+    M[0][0] = CoeffTraits<CoeffT>::one();
+    for(int n = 0; n < _degree; n++) {
+      for(int j = 0; j <= n; j++) {
+        M[j + 1][n + 1] = Basis::alpha(n) * M[j][n];
+        if(n > 0) {
+          M[j][n + 1] = M[j][n + 1] -
+                        Basis::gamma(n) * M[j][n - 1];
+        }
+      }
+    }
+    OrthogonalPolynomial m(*this);
+    for(int d = 0; d < _dim; d++) {
+      m.apply_axis(M, d);
+    }
+    Polynomial<CoeffT, _degree, _dim> p;
+    for(int i = 0; i < num_coeffs; i++) {
+      p.data()[i] = m.coeffs[i];
+    }
+    return p;
+  }
+
+  CoeffT *data() noexcept { return &coeffs[0]; }
+
+  const CoeffT *data() const noexcept { return &coeffs[0]; }
+
+  template <typename... int_list,
+            typename std::enable_if<
+                sizeof...(int_list) == _dim, int>::type = 0>
+  CoeffT coeff(int_list... args) const noexcept {
+    return coeff(Array<int, _dim>(args...));
+  }
+
+  template <typename... int_list,
+            typename std::enable_if<
+                sizeof...(int_list) == _dim, int>::type = 0>
+  CoeffT &coeff(int_list... args) noexcept {
+    return coeff(Array<int, _dim>(args...));
+  }
+
+  CoeffT coeff(const Array<int, _dim> &exponents) const
+      noexcept {
+    return coeffs[Utilities::term_index(exponents)];
+  }
+
+  CoeffT &coeff(
+      const Array<int, _dim> &exponents) noexcept {
+    return coeffs[Utilities::term_index(exponents)];
+  }
+
+  CoeffT eval(const Array<CoeffT, _dim> &point) const
+      noexcept {
+    Array<int, _dim> exponents;
+    return clenshaw(0, _degree, exponents, point);
+  }
+
+  template <typename... subs_list,
+            typename std::enable_if<
+                sizeof...(subs_list) == _dim,
+                int>::type = 0>
+  CoeffT eval(subs_list... vars) const noexcept {
+    return eval(Array<CoeffT, _dim>(vars...));
+  }
+
+  /* Runs the family's backward recurrence along every
+   * fiber of the variable */
+  OrthogonalPolynomial<CoeffT,
+                       (_degree > 0 ? _degree - 1 : 0),
+                       _dim, Family>
+  differentiate(int variable) const {
+    assert(variable >= 0);
+    assert(variable < _dim);
+    OrthogonalPolynomial<CoeffT,
+                         (_degree > 0 ? _degree - 1 : 0),
+                         _dim, Family>
+        derivative((Tags::Zero_Tag()));
+    const std::vector<Array<int, _dim> > terms =
+        Utilities::term_exponents<_dim>(_degree);
+    std::vector<CoeffT> fiber(_degree + 2);
+    for(const Array<int, _dim> &base : terms) {
+      /* Visit each fiber once, from its lowest term */
+      if(base[variable] != 0) {
+        continue;
+      }
+      const int top = _degree - CTMath::sum(base);
+      Array<int, _dim> e(base);
+      for(int k = 0; k < top + 2; k++) {
+        fiber[k] = CoeffTraits<CoeffT>::zero();
+      }
+      for(int k = top; k >= 1; k--) {
+        e[variable] = k;
+        fiber[k - 1] = CoeffTraits<CoeffT>::fma(
+            Basis::derivative_weight(k), coeff(e),
+            Basis::derivative_carry(k) * fiber[k + 1]);
+      }
+      fiber[0] = fiber[0] * Basis::derivative_first_scale();
+      for(int k = 0; k < top; k++) {
+        e[variable] = k;
+        derivative.coeff(e) = fiber[k];
+      }
+    }
+    return derivative;
+  }
+
+  /* The antiderivative in the variable which is constant
+   * at x_variable = 0, like Polynomial::integrate.
+   * Each basis function integrates to at most two others,
+   * so this is a sparse update per coefficient */
+  OrthogonalPolynomial<CoeffT, _degree + 1, _dim, Family>
+  integrate(int variable,
+            CoeffT constant = CoeffTraits<CoeffT>::zero())
+      const {
+    assert(variable >= 0);
+    assert(variable < _dim);
+    using Integral =
+        OrthogonalPolynomial<CoeffT, _degree + 1, _dim,
+                             Family>;
+    Integral integral((Tags::Zero_Tag()));
+    const std::vector<Array<int, _dim> > terms =
+        Utilities::term_exponents<_dim>(_degree);
+    for(int i = 0; i < num_coeffs; i++) {
+      Array<int, _dim> e(terms[i]);
+      const int k = e[variable];
+      const std::pair<CoeffT, CoeffT> w =
+          Basis::integral(k);
+      e[variable] = k + 1;
+      integral.coeff(e) = CoeffTraits<CoeffT>::fma(
+          w.first, coeffs[i], integral.coeff(e));
+      if(k > 0) {
+        e[variable] = k - 1;
+        integral.coeff(e) =
+            integral.coeff(e) - w.second * coeffs[i];
+      }
+    }
+    /* P_k(0) */
+    std::vector<CoeffT> at_zero(_degree + 2);
+    at_zero[0] = CoeffTraits<CoeffT>::one();
+    at_zero[1] = CoeffTraits<CoeffT>::zero();
+    for(int k = 1; k <= _degree; k++) {
+      at_zero[k + 1] = -Basis::gamma(k) * at_zero[k - 1];
+    }
+    /* Subtract each fiber's value on x_variable = 0 from
+     * its constant term */
+    const std::vector<Array<int, _dim> > integral_terms =
+        Utilities::term_exponents<_dim>(_degree + 1);
+    for(const Array<int, _dim> &base : integral_terms) {
+      if(base[variable] != 0) {
+        continue;
+      }
+      Array<int, _dim> e(base);
+      CoeffT value = CoeffTraits<CoeffT>::zero();
+      for(int k = 1; k <= _degree + 1 - CTMath::sum(base);
+          k++) {
+        e[variable] = k;
+        value = CoeffTraits<CoeffT>::fma(
+            at_zero[k], integral.coeff(e), value);
+      }
+      integral.coeff(base) = -value;
+    }
+    integral.data()[0] = integral.data()[0] + constant;
+    return integral;
+  }
+
+  OrthogonalPolynomial operator+(
+      const OrthogonalPolynomial &rhs) const noexcept {
+    OrthogonalPolynomial s;
+    for(int i = 0; i < num_coeffs; i++) {
+      s.coeffs[i] = coeffs[i] + rhs.coeffs[i];
+    }
+    return s;
+  }
+
+  OrthogonalPolynomial operator-(
+      const OrthogonalPolynomial &rhs) const noexcept {
+    OrthogonalPolynomial s;
+    for(int i = 0; i < num_coeffs; i++) {
+      s.coeffs[i] = coeffs[i] - rhs.coeffs[i];
+    }
+    return s;
+  }
+
+  OrthogonalPolynomial operator*(const CoeffT &scale) const
+      noexcept {
+    OrthogonalPolynomial s;
+    for(int i = 0; i < num_coeffs; i++) {
+      s.coeffs[i] = coeffs[i] * scale;
+    }
+    return s;
+  }
+
+ private:
+  /* M[j][n] is the coefficient of basis function j of the
+   * target basis in basis function n of the source */
+  using Matrix =
+      Array<Array<CoeffT, _degree + 1>, _degree + 1>;
+
+  static Matrix zero_matrix() noexcept {
+    Matrix M;
+    for(int i = 0; i <= _degree; i++) {
+      for(int j = 0; j <= _degree; j++) {
+        M[i][j] = CoeffTraits<CoeffT>::zero();
+      }
+    }
+    return M;
+  }
+
+  /* Changes the basis of one variable; M is upper
+   * triangular so the total degree doesn't increase */
+  void apply_axis(const Matrix &M, int axis) noexcept {
+    const std::vector<Array<int, _dim> > terms =
+        Utilities::term_exponents<_dim>(_degree);
+    Array<CoeffT, num_coeffs> out((Tags::Zero_Tag()));
+    for(int i = 0; i < num_coeffs; i++) {
+      Array<int, _dim> e(terms[i]);
+      const int n = e[axis];
+      for(int j = 0; j <= n; j++) {
+        if(CoeffTraits<CoeffT>::is_zero(M[j][n])) {
+          continue;
+        }
+        e[axis] = j;
+        CoeffT &c = out[Utilities::term_index(e)];
+        c = CoeffTraits<CoeffT>::fma(M[j][n], coeffs[i], c);
+      }
+    }
+    coeffs = out;
+  }
+
+  /* Evaluates the terms with the exponents of the
+   * variables before cur_dim fixed, which have exp_left
+   * degrees left for the rest; the coefficient of
+   * P_k(x_cur_dim) is the evaluation of the remaining
+   * variables, and the series in x_cur_dim is summed with
+   * Clenshaw's recurrence, y_k =
+   * b_k + alpha(k) x y_(k + 1) - gamma(k + 1) y_(k + 2)
+   */
+  CoeffT clenshaw(int cur_dim, int exp_left,
+                  Array<int, _dim> &exponents,
+                  const Array<CoeffT, _dim> &point) const
+      noexcept {
+    const CoeffT x = point[cur_dim];
+    CoeffT y1 = CoeffTraits<CoeffT>::zero();
+    CoeffT y2 = CoeffTraits<CoeffT>::zero();
+    for(int k = exp_left; k >= 0; k--) {
+      exponents[cur_dim] = k;
+      CoeffT b;
+      if(cur_dim == _dim - 1) {
+        b = coeffs[Utilities::term_index(exponents)];
+      } else {
+        b = clenshaw(cur_dim + 1, exp_left - k, exponents,
+                     point);
+      }
+      const CoeffT y = b + Basis::alpha(k) * x * y1 -
+                       Basis::gamma(k + 1) * y2;
+      y2 = y1;
+      y1 = y;
+    }
+    return y1;
+  }
+
+  Array<CoeffT, num_coeffs> coeffs;
+};
+
+template <typename CoeffT, int _degree, int _dim>
+using ChebyshevPolynomial =
+    OrthogonalPolynomial<CoeffT, _degree, _dim, Chebyshev>;
+
+template <typename CoeffT, int _degree, int _dim>
+using LegendrePolynomial =
+    OrthogonalPolynomial<CoeffT, _degree, _dim, Legendre>;
+}  // namespace Numerical
+
+#endif  // _ORTHOGONAL_POLYNOMIAL_HPP_
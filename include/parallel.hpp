@@ -0,0 +1,495 @@
+#ifndef _PARALLEL_HPP_
+#define _PARALLEL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+namespace Parallel {
+
+/* A bump allocator for per-thread temporaries.
+ * Objects created in the arena live until reset() is
+ * called, at which point their destructors are run (unless
+ * they are trivially destructible) and the memory is reused
+ * for the next batch of allocations.
+ */
+class ScratchArena {
+ public:
+  explicit ScratchArena(std::size_t block_size = 1 << 16)
+      : block_size(block_size), cur_block(0), cur_used(0) {}
+
+  ScratchArena(const ScratchArena &) = delete;
+  ScratchArena &operator=(const ScratchArena &) = delete;
+
+  ~ScratchArena() { reset(); }
+
+  void *allocate(std::size_t size, std::size_t align) {
+    assert(align > 0 && (align & (align - 1)) == 0);
+    while(cur_block < blocks.size()) {
+      Block &b = blocks[cur_block];
+      std::uintptr_t base =
+          reinterpret_cast<std::uintptr_t>(b.data.get());
+      std::uintptr_t ptr = (base + cur_used + align - 1) &
+                           ~(std::uintptr_t(align) - 1);
+      if(ptr + size <= base + b.size) {
+        cur_used = ptr + size - base;
+        return reinterpret_cast<void *>(ptr);
+      }
+      cur_block++;
+      cur_used = 0;
+    }
+    const std::size_t new_size =
+        std::max(block_size, size + align);
+    blocks.push_back(Block{
+        std::unique_ptr<char[]>(new char[new_size]),
+        new_size});
+    cur_block = blocks.size() - 1;
+    cur_used = 0;
+    return allocate(size, align);
+  }
+
+  template <typename T, typename... Args>
+  T *create(Args &&... args) {
+    void *mem = allocate(sizeof(T), alignof(T));
+    T *obj = new(mem) T(std::forward<Args>(args)...);
+    if(!std::is_trivially_destructible<T>::value) {
+      destructors.push_back(Destructor{
+          obj, [](void *p) { static_cast<T *>(p)->~T(); }});
+    }
+    return obj;
+  }
+
+  /* Destroys everything created since the last reset, but
+   * keeps the blocks around for the next batch */
+  void reset() noexcept {
+    for(auto d = destructors.rbegin();
+        d != destructors.rend(); ++d) {
+      d->destroy(d->obj);
+    }
+    destructors.clear();
+    cur_block = 0;
+    cur_used = 0;
+  }
+
+  std::size_t capacity() const noexcept {
+    std::size_t total = 0;
+    for(const Block &b : blocks) {
+      total += b.size;
+    }
+    return total;
+  }
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    std::size_t size;
+  };
+
+  struct Destructor {
+    void *obj;
+    void (*destroy)(void *);
+  };
+
+  std::size_t block_size;
+  std::vector<Block> blocks;
+  std::size_t cur_block;
+  std::size_t cur_used;
+  std::vector<Destructor> destructors;
+};
+
+enum class Reduction {
+  /* Partial results are formed over fixed chunks of the
+   * element range and combined in chunk order, so the
+   * result is bit-identical for any thread count */
+  Deterministic,
+  /* Partial results are formed per thread and combined in
+   * thread order; faster, but the rounding depends on how
+   * the work was stolen */
+  Unordered,
+};
+
+/* A persistent pool of threads which executes loops over
+ * element ranges.
+ * Each thread starts with an equal contiguous share of the
+ * range and takes grain sized chunks from the front of it.
+ * When a thread runs out of work it steals the back half
+ * of the largest remaining range, so imbalanced loops (ie.
+ * p-adaptive meshes) still keep every thread busy.
+ * The calling thread participates as thread 0.
+ * If func throws, the remaining chunks are abandoned and
+ * the first exception is rethrown on the calling thread
+ * once every thread has stopped using func.
+ */
+class Scheduler {
+ public:
+  explicit Scheduler(
+      int num_threads = default_num_threads())
+      : threads_count(std::max(1, num_threads)),
+        ranges(threads_count),
+        arenas(threads_count),
+        generation(0),
+        workers_active(0),
+        shutdown(false) {
+    for(int i = 0; i < threads_count; i++) {
+      arenas[i].reset(new ScratchArena());
+    }
+    for(int i = 1; i < threads_count; i++) {
+      workers.emplace_back([this, i]() { worker_loop(i); });
+    }
+  }
+
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  ~Scheduler() {
+    {
+      std::lock_guard<std::mutex> lock(job_mutex);
+      shutdown = true;
+    }
+    job_cv.notify_all();
+    for(std::thread &w : workers) {
+      w.join();
+    }
+  }
+
+  static int default_num_threads() noexcept {
+    const int hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+  }
+
+  int num_threads() const noexcept { return threads_count; }
+
+  ScratchArena &arena(int thread) noexcept {
+    assert(thread >= 0);
+    assert(thread < threads_count);
+    return *arenas[thread];
+  }
+
+  /* Calls func(element, thread) for every element in
+   * [begin, end)
+   * grain is the number of elements a thread takes at once;
+   * zero picks one based on the range and thread count
+   */
+  template <typename Func>
+  void parallel_for(int begin, int end, Func &&func,
+                    int grain = 0) {
+    parallel_for_chunks(
+        begin, end,
+        [&func](int lo, int hi, int thread) {
+          for(int e = lo; e < hi; e++) {
+            func(e, thread);
+          }
+        },
+        grain);
+  }
+
+  /* Calls func(lo, hi, thread) on disjoint chunks which
+   * cover [begin, end); useful when the kernel can amortize
+   * setup over several elements
+   */
+  template <typename Func>
+  void parallel_for_chunks(int begin, int end, Func &&func,
+                           int grain = 0) {
+    if(end <= begin) {
+      return;
+    }
+    const int count = end - begin;
+    if(grain <= 0) {
+      grain = std::max(1, count / (8 * threads_count));
+    }
+    const int cur = current_thread();
+    if(threads_count == 1 || cur >= 0 || count <= grain) {
+      /* Nested loops run serially on the calling thread so
+       * they can't deadlock waiting for the pool */
+      const int thread = std::max(0, cur);
+      RegionGuard guard(this, thread);
+      for(int lo = begin; lo < end; lo += grain) {
+        func(lo, std::min(end, lo + grain), thread);
+      }
+      return;
+    }
+    run_job(begin, end, grain,
+            [&func](int lo, int hi, int thread) {
+              func(lo, hi, thread);
+            });
+  }
+
+  /* Computes combine(...combine(identity, map(begin))...,
+   * map(end - 1))
+   * In deterministic mode the grouping only depends on
+   * grain, never on the number of threads or the order the
+   * chunks were executed in
+   */
+  template <typename T, typename Map, typename Combine>
+  T reduce(int begin, int end, const T &identity, Map &&map,
+           Combine &&combine,
+           Reduction mode = Reduction::Deterministic,
+           int grain = 64) {
+    if(end <= begin) {
+      return identity;
+    }
+    assert(grain > 0);
+    if(mode == Reduction::Deterministic) {
+      const int num_chunks =
+          (end - begin + grain - 1) / grain;
+      std::vector<T> partials(num_chunks, identity);
+      parallel_for(
+          0, num_chunks,
+          [&](int chunk, int thread) {
+            const int lo = begin + chunk * grain;
+            const int hi = std::min(end, lo + grain);
+            T partial = identity;
+            for(int e = lo; e < hi; e++) {
+              partial = combine(partial, map(e, thread));
+            }
+            partials[chunk] = partial;
+          },
+          1);
+      T total = identity;
+      for(const T &partial : partials) {
+        total = combine(total, partial);
+      }
+      return total;
+    } else {
+      std::vector<T> partials(threads_count, identity);
+      parallel_for(
+          begin, end,
+          [&](int e, int thread) {
+            partials[thread] =
+                combine(partials[thread], map(e, thread));
+          },
+          grain);
+      T total = identity;
+      for(const T &partial : partials) {
+        total = combine(total, partial);
+      }
+      return total;
+    }
+  }
+
+ private:
+  using ChunkFunc = std::function<void(int, int, int)>;
+
+  struct Range {
+    std::mutex lock;
+    int lo = 0;
+    int hi = 0;
+  };
+
+  struct Region {
+    const Scheduler *sched = nullptr;
+    int thread = -1;
+  };
+
+  static Region &region() noexcept {
+    static thread_local Region cur;
+    return cur;
+  }
+
+  /* The index of the calling thread if it's already
+   * running a loop for this scheduler, -1 otherwise */
+  int current_thread() const noexcept {
+    return region().sched == this ? region().thread : -1;
+  }
+
+  struct RegionGuard {
+    RegionGuard(const Scheduler *sched, int thread)
+        : prev(region()) {
+      region().sched = sched;
+      region().thread = thread;
+    }
+    ~RegionGuard() { region() = prev; }
+    Region prev;
+  };
+
+  void run_job(int begin, int end, int grain,
+               const ChunkFunc &func) {
+    const int count = end - begin;
+    for(int i = 0; i < threads_count; i++) {
+      std::lock_guard<std::mutex> lock(ranges[i].lock);
+      ranges[i].lo = begin + int(std::int64_t(count) * i /
+                                 threads_count);
+      ranges[i].hi = begin + int(std::int64_t(count) *
+                                 (i + 1) / threads_count);
+    }
+    {
+      std::lock_guard<std::mutex> lock(job_mutex);
+      job = &func;
+      job_grain = grain;
+      job_error = nullptr;
+      job_cancelled = false;
+      workers_active = threads_count - 1;
+      generation++;
+    }
+    job_cv.notify_all();
+
+    execute(0);
+
+    std::exception_ptr error;
+    {
+      /* Always wait; the workers may still be using func
+       * even if thread 0 failed */
+      std::unique_lock<std::mutex> lock(job_mutex);
+      done_cv.wait(
+          lock, [this]() { return workers_active == 0; });
+      job = nullptr;
+      error = job_error;
+      job_error = nullptr;
+    }
+    if(error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  void worker_loop(int thread) {
+    std::uint64_t seen = 0;
+    for(;;) {
+      {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        job_cv.wait(lock, [&]() {
+          return shutdown || generation != seen;
+        });
+        if(shutdown) {
+          return;
+        }
+        seen = generation;
+      }
+      execute(thread);
+      {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        workers_active--;
+      }
+      done_cv.notify_one();
+    }
+  }
+
+  /* Runs chunks until there are none left; exceptions are
+   * kept for run_job to rethrow */
+  void execute(int thread) noexcept {
+    RegionGuard guard(this, thread);
+    const ChunkFunc &func = *job;
+    const int grain = job_grain;
+    int lo, hi;
+    try {
+      while(!job_cancelled.load(
+                std::memory_order_relaxed) &&
+            (take_own(thread, grain, lo, hi) ||
+             steal(thread, grain, lo, hi))) {
+        func(lo, hi, thread);
+      }
+    } catch(...) {
+      cancel(std::current_exception());
+    }
+  }
+
+  /* Records the first error and empties every range so
+   * the other threads stop taking chunks; the flag also
+   * stops a thread which was midway through a steal */
+  void cancel(std::exception_ptr error) noexcept {
+    {
+      std::lock_guard<std::mutex> lock(job_mutex);
+      if(!job_error) {
+        job_error = error;
+      }
+    }
+    job_cancelled = true;
+    for(Range &r : ranges) {
+      std::lock_guard<std::mutex> lock(r.lock);
+      r.lo = r.hi;
+    }
+  }
+
+  bool take_own(int thread, int grain, int &lo, int &hi) {
+    Range &r = ranges[thread];
+    std::lock_guard<std::mutex> lock(r.lock);
+    if(r.lo >= r.hi) {
+      return false;
+    }
+    lo = r.lo;
+    hi = std::min(r.hi, r.lo + grain);
+    r.lo = hi;
+    return true;
+  }
+
+  bool steal(int thread, int grain, int &lo, int &hi) {
+    for(;;) {
+      /* Look for the victim with the most work left; its
+       * range can change once its lock is released, so
+       * recheck after acquiring it again */
+      int victim = -1;
+      int best = 0;
+      for(int i = 1; i < threads_count; i++) {
+        const int v = (thread + i) % threads_count;
+        Range &r = ranges[v];
+        std::lock_guard<std::mutex> lock(r.lock);
+        if(r.hi - r.lo > best) {
+          best = r.hi - r.lo;
+          victim = v;
+        }
+      }
+      if(victim < 0) {
+        return false;
+      }
+      int stolen_lo, stolen_hi;
+      {
+        Range &r = ranges[victim];
+        std::lock_guard<std::mutex> lock(r.lock);
+        const int left = r.hi - r.lo;
+        if(left <= 0) {
+          continue;
+        }
+        /* Leave the victim at least the chunk it would take
+         * next, and take the back half of the rest */
+        const int keep =
+            std::min(left, std::max(grain, left / 2));
+        stolen_lo = r.lo + keep;
+        stolen_hi = r.hi;
+        if(stolen_lo >= stolen_hi) {
+          /* Too little left to split, take it all */
+          stolen_lo = r.lo;
+        }
+        r.hi = stolen_lo;
+      }
+      {
+        Range &own = ranges[thread];
+        std::lock_guard<std::mutex> lock(own.lock);
+        own.lo = stolen_lo;
+        own.hi = stolen_hi;
+      }
+      return take_own(thread, grain, lo, hi);
+    }
+  }
+
+  const int threads_count;
+  std::vector<Range> ranges;
+  std::vector<std::unique_ptr<ScratchArena> > arenas;
+  std::vector<std::thread> workers;
+
+  std::mutex job_mutex;
+  std::condition_variable job_cv;
+  std::condition_variable done_cv;
+  const ChunkFunc *job = nullptr;
+  int job_grain = 1;
+  std::exception_ptr job_error;
+  std::atomic<bool> job_cancelled{false};
+  std::uint64_t generation;
+  int workers_active;
+  bool shutdown;
+};
+}  // namespace Parallel
+}  // namespace Numerical
+
+#endif  // _PARALLEL_HPP_
@@ -0,0 +1,318 @@
+#ifndef _PARTITION_HPP_
+#define _PARTITION_HPP_
+
+#include <array.hpp>
+#include <tags.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace Numerical {
+namespace Parallel {
+
+/* Factors num_ranks into a grid of ranks over the cells
+ * which minimizes the number of cut faces
+ */
+template <int dim>
+Array<int, dim> balanced_rank_grid(
+    int num_ranks, const Array<int, dim> &cells) {
+  Array<int, dim> best((Tags::Zero_Tag()));
+  long best_cut = -1;
+  Array<int, dim> cur;
+  /* Enumerate every factorization, there are few of them */
+  std::function<void(int, int)> search = [&](int d,
+                                             int left) {
+    if(d == dim - 1) {
+      cur[d] = left;
+      if(cur[d] > cells[d]) {
+        return;
+      }
+      long cut = 0;
+      for(int i = 0; i < dim; i++) {
+        long face = cur[i] - 1;
+        for(int j = 0; j < dim; j++) {
+          if(j != i) {
+            face *= cells[j];
+          }
+        }
+        cut += face;
+      }
+      if(best_cut < 0 || cut < best_cut) {
+        best_cut = cut;
+        best = cur;
+      }
+      return;
+    }
+    for(int f = 1; f <= left && f <= cells[d]; f++) {
+      if(left % f == 0) {
+        cur[d] = f;
+        search(d + 1, left / f);
+      }
+    }
+  };
+  search(0, num_ranks);
+  assert(best_cut >= 0);
+  return best;
+}
+
+/* Block decomposition of a Cartesian grid of elements over
+ * a Cartesian grid of ranks, with ghost_layers layers of
+ * ghost elements around each block.
+ *
+ * Every element stored on a rank has a local index, and the
+ * local storage is ordered as
+ * [ interior | boundary | ghosts from neighbor 0 | ... ]
+ * Interior elements aren't needed by any other rank, so
+ * they can be computed on while the halo is in flight.
+ * The ghosts from each neighbor are contiguous, so halos
+ * can be received directly into the element storage.
+ */
+template <int dim>
+class CartesianPartition {
+ public:
+  struct Neighbor {
+    int rank;
+    /* Local indices of owned elements the neighbor needs,
+     * in the order the neighbor expects them */
+    std::vector<int> send;
+    /* Ghosts owned by the neighbor are stored in
+     * [recv_offset, recv_offset + recv_count) */
+    int recv_offset;
+    int recv_count;
+    /* The send list is one contiguous run of local
+     * indices, so it can be sent straight from the element
+     * storage */
+    bool send_contiguous;
+  };
+
+  CartesianPartition(const Array<int, dim> &cells,
+                     const Array<int, dim> &rank_grid,
+                     int rank, int ghost_layers = 1)
+      : cells(cells),
+        rank_grid(rank_grid),
+        my_rank(rank),
+        ghost_layers(ghost_layers) {
+    assert(rank >= 0);
+    assert(rank < grid_size(rank_grid));
+    assert(ghost_layers >= 0);
+    build();
+  }
+
+  int rank() const noexcept { return my_rank; }
+
+  int num_interior() const noexcept { return interior; }
+
+  int num_owned() const noexcept { return owned; }
+
+  int num_ghost() const noexcept {
+    return int(local_to_global.size()) - owned;
+  }
+
+  int num_local() const noexcept {
+    return int(local_to_global.size());
+  }
+
+  int num_global() const noexcept {
+    return grid_size(cells);
+  }
+
+  int global_index(int local) const noexcept {
+    assert(local >= 0);
+    assert(local < num_local());
+    return local_to_global[local];
+  }
+
+  /* Returns -1 if the element isn't stored on this rank */
+  int local_index(int global) const noexcept {
+    auto found = global_to_local.find(global);
+    return found == global_to_local.end() ? -1
+                                          : found->second;
+  }
+
+  const std::vector<Neighbor> &neighbors() const noexcept {
+    return nbrs;
+  }
+
+  int owner(const Array<int, dim> &cell) const noexcept {
+    int r = 0;
+    for(int i = 0; i < dim; i++) {
+      int block = 0;
+      while(block_end(i, block) <= cell[i]) {
+        block++;
+      }
+      r = r * rank_grid[i] + block;
+    }
+    return r;
+  }
+
+  Array<int, dim> cell_coords(int global) const noexcept {
+    Array<int, dim> c;
+    for(int i = dim - 1; i >= 0; i--) {
+      c[i] = global % cells[i];
+      global /= cells[i];
+    }
+    return c;
+  }
+
+  int cell_index(const Array<int, dim> &c) const noexcept {
+    int global = 0;
+    for(int i = 0; i < dim; i++) {
+      global = global * cells[i] + c[i];
+    }
+    return global;
+  }
+
+ private:
+  static int grid_size(const Array<int, dim> &a) {
+    int p = 1;
+    for(int i = 0; i < dim; i++) {
+      p *= a[i];
+    }
+    return p;
+  }
+
+  /* Blocks along a dimension differ in size by at most 1 */
+  int block_begin(int d, int block) const noexcept {
+    return int(long(cells[d]) * block / rank_grid[d]);
+  }
+
+  int block_end(int d, int block) const noexcept {
+    return block_begin(d, block + 1);
+  }
+
+  Array<int, dim> rank_coords(int r) const noexcept {
+    Array<int, dim> c;
+    for(int i = dim - 1; i >= 0; i--) {
+      c[i] = r % rank_grid[i];
+      r /= rank_grid[i];
+    }
+    return c;
+  }
+
+  /* Calls f(global) for every cell in the block of rank r
+   * expanded by layers, in increasing global order */
+  template <typename Func>
+  void for_cells(int r, int layers, Func &&f) const {
+    const Array<int, dim> rc = rank_coords(r);
+    Array<int, dim> lo, hi, c;
+    for(int i = 0; i < dim; i++) {
+      lo[i] = std::max(0, block_begin(i, rc[i]) - layers);
+      hi[i] =
+          std::min(cells[i], block_end(i, rc[i]) + layers);
+      if(lo[i] >= hi[i]) {
+        return;
+      }
+      c[i] = lo[i];
+    }
+    for(;;) {
+      f(cell_index(c));
+      int i = dim - 1;
+      for(; i >= 0; i--) {
+        if(++c[i] < hi[i]) {
+          break;
+        }
+        c[i] = lo[i];
+      }
+      if(i < 0) {
+        return;
+      }
+    }
+  }
+
+  void build() {
+    /* Ghosts grouped by owner; the map keeps the neighbors
+     * and the ghosts sorted */
+    std::map<int, std::vector<int> > ghosts;
+    for_cells(my_rank, ghost_layers, [&](int global) {
+      const int o = owner(cell_coords(global));
+      if(o != my_rank) {
+        ghosts[o].push_back(global);
+      }
+    });
+
+    /* Owned elements each neighbor needs as ghosts; the
+     * neighbors are the same ranks we need ghosts from */
+    std::map<int, std::vector<int> > sends;
+    std::map<int, std::vector<int> > needed_by;
+    for(const auto &g : ghosts) {
+      const int nbr = g.first;
+      for_cells(nbr, ghost_layers, [&](int global) {
+        if(owner(cell_coords(global)) == my_rank) {
+          sends[nbr].push_back(global);
+          needed_by[global].push_back(nbr);
+        }
+      });
+    }
+
+    /* Interior elements don't touch any ghosts either, as
+     * the ghost layers are symmetric.
+     * Interior first, then the boundary grouped by the set
+     * of neighbors needing each element so that sends are
+     * contiguous whenever the neighbor sets don't
+     * overlap */
+    std::vector<int> interior_cells;
+    std::vector<std::pair<std::vector<int>, int> >
+        boundary_cells;
+    for_cells(my_rank, 0, [&](int global) {
+      auto found = needed_by.find(global);
+      if(found == needed_by.end()) {
+        interior_cells.push_back(global);
+      } else {
+        boundary_cells.emplace_back(found->second, global);
+      }
+    });
+    std::sort(boundary_cells.begin(), boundary_cells.end());
+
+    for(int global : interior_cells) {
+      add_local(global);
+    }
+    for(const auto &b : boundary_cells) {
+      add_local(b.second);
+    }
+    interior = int(interior_cells.size());
+    owned = num_local();
+
+    for(const auto &g : ghosts) {
+      Neighbor n;
+      n.rank = g.first;
+      n.recv_offset = num_local();
+      n.recv_count = int(g.second.size());
+      for(int global : g.second) {
+        add_local(global);
+      }
+      for(int global : sends[n.rank]) {
+        n.send.push_back(local_index(global));
+      }
+      n.send_contiguous = true;
+      for(int i = 1; i < int(n.send.size()); i++) {
+        if(n.send[i] != n.send[i - 1] + 1) {
+          n.send_contiguous = false;
+        }
+      }
+      nbrs.push_back(n);
+    }
+  }
+
+  void add_local(int global) {
+    global_to_local[global] = num_local();
+    local_to_global.push_back(global);
+  }
+
+  Array<int, dim> cells;
+  Array<int, dim> rank_grid;
+  int my_rank;
+  int ghost_layers;
+
+  int interior;
+  int owned;
+  std::vector<int> local_to_global;
+  std::map<int, int> global_to_local;
+  std::vector<Neighbor> nbrs;
+};
+}  // namespace Parallel
+}  // namespace Numerical
+
+#endif  // _PARTITION_HPP_
@@ -4,6 +4,7 @@
 
 #include <array.hpp>
 #include <ctmath.hpp>
+#include <field.hpp>
 #include <polynomial_utils.hpp>
 #include <tags.hpp>
 
@@ -31,8 +32,27 @@ class Polynomial {
   Polynomial() {}
 
   Polynomial(const Tags::Zero_Tag &&)
-      : coeffs(Tags::Zero_Tag()),
-        lower_degree(Tags::Zero_Tag()) {}
+      : coeffs(Tags::Zero_Tag()) {}
+
+  /* Converts each coefficient of p to CoeffT */
+  template <typename OtherT>
+  explicit Polynomial(
+      const Polynomial<OtherT, _degree, _dim> &p) {
+    for(int i = 0; i < num_coeffs; i++) {
+      coeffs[i] = static_cast<CoeffT>(p.data()[i]);
+    }
+  }
+
+  /* The number of coefficients stored; they're stored
+   * contiguously in order of increasing term degree, and in
+   * the order coeff_iterator visits them within a degree
+   */
+  static constexpr const int num_coeffs =
+      Utilities::poly_num_coeffs<int>(_degree, _dim);
+
+  CoeffT *data() noexcept { return &coeffs[0]; }
+
+  const CoeffT *data() const noexcept { return &coeffs[0]; }
 
   /* Takes an array of size dim as input
    * The indices in the array correspond to the dimension
@@ -59,26 +79,12 @@ class Polynomial {
 
   CoeffT coeff(const Array<int, _dim> &exponents) const
       noexcept {
-    if(CTMath::sum(exponents) == _degree) {
-      int idx = get_coeff_idx_helper(_degree, exponents);
-      assert(idx >= 0);
-      assert(idx < num_coeffs);
-      return coeffs[idx];
-    } else {
-      return lower_degree.coeff(exponents);
-    }
+    return coeffs[get_flat_idx(exponents)];
   }
 
   CoeffT &coeff(
       const Array<int, _dim> &exponents) noexcept {
-    if(CTMath::sum(exponents) == _degree) {
-      int idx = get_coeff_idx_helper(_degree, exponents);
-      assert(idx >= 0);
-      assert(idx < num_coeffs);
-      return coeffs[idx];
-    } else {
-      return lower_degree.coeff(exponents);
-    }
+    return coeffs[get_flat_idx(exponents)];
   }
 
   Polynomial<CoeffT, _degree, _dim> operator+(
@@ -194,7 +200,9 @@ class Polynomial {
       Array<int, _dim> integral_eq(exponents);
       integral_eq[variable]++;
       CoeffT factor =
-          CoeffT(1) / CoeffT(integral_eq[variable]);
+          CoeffTraits<CoeffT>::one() /
+          CoeffTraits<CoeffT>::broadcast(
+              integral_eq[variable]);
       integral.coeff(integral_eq) =
           factor * coeff(exponents);
     });
@@ -215,7 +223,9 @@ class Polynomial {
       if(buf[variable] > 0) {
         buf[variable]--;
         derivative.coeff(buf) =
-            CoeffT(exponents[variable]) * coeff(exponents);
+            CoeffTraits<CoeffT>::broadcast(
+                exponents[variable]) *
+            coeff(exponents);
       }
     });
     return derivative;
@@ -227,7 +237,7 @@ class Polynomial {
     Polynomial<CoeffT, _degree, _dim - 1> s(
         (Tags::Zero_Tag()));
     Array<CoeffT, _degree + 1> factors;
-    factors[0] = 1.0;
+    factors[0] = CoeffTraits<CoeffT>::one();
     for(int i = 1; i < _degree + 1; i++) {
       factors[i] = slice_pos * factors[i - 1];
     }
@@ -254,7 +264,8 @@ class Polynomial {
       if(CTMath::sum(exponents) <= P_Cast::degree) {
         reduced.coeff(exponents) = coeff(exponents);
       } else {
-        assert(coeff(exponents) == CoeffT(0.0));
+        assert(CoeffTraits<CoeffT>::is_zero(
+            coeff(exponents)));
       }
     });
     return reduced;
@@ -269,7 +280,8 @@ class Polynomial {
       if(CTMath::sum(exponents) <= P_Cast::degree) {
         reduced.coeff(exponents) = coeff(exponents);
       } else {
-        assert(coeff(exponents) == CoeffT(0.0));
+        assert(CoeffTraits<CoeffT>::is_zero(
+            coeff(exponents)));
       }
     });
     return reduced;
@@ -318,14 +330,16 @@ class Polynomial {
                      subs_list... vars) const noexcept {
     constexpr const auto cur_dim =
         _dim - sizeof...(subs_list) - 1;
-    CoeffT factor = 1.0;
-    CoeffT term_sum = 0.0;
+    CoeffT factor = CoeffTraits<CoeffT>::one();
+    CoeffT term_sum = CoeffTraits<CoeffT>::zero();
     for(exponents[cur_dim] = 0;
         exponents[cur_dim] <= exp_left;
         ++exponents[cur_dim]) {
-      term_sum += factor *
-                  eval_helper(exp_left - exponents[cur_dim],
-                              exponents, vars...);
+      term_sum = CoeffTraits<CoeffT>::fma(
+          factor,
+          eval_helper(exp_left - exponents[cur_dim],
+                      exponents, vars...),
+          term_sum);
       factor *= cur_var;
     }
     return term_sum;
@@ -335,57 +349,29 @@ class Polynomial {
                      Array<int, _dim> &exponents,
                      CoeffT cur_var) const noexcept {
     constexpr const auto cur_dim = _dim - 1;
-    CoeffT term_sum = 0.0;
-    CoeffT factor = 1.0;
+    CoeffT term_sum = CoeffTraits<CoeffT>::zero();
+    CoeffT factor = CoeffTraits<CoeffT>::one();
     for(exponents[cur_dim] = 0;
         exponents[cur_dim] <= exp_left;
         ++exponents[cur_dim]) {
-      term_sum += factor * coeff(exponents);
+      term_sum = CoeffTraits<CoeffT>::fma(
+          factor, coeff(exponents), term_sum);
       factor *= cur_var;
     }
     return term_sum;
   }
 
-  template <typename... int_list,
-            typename std::enable_if<
-                sizeof...(int_list) == _dim, int>::type = 0>
-  static int get_coeff_idx(int_list... args) noexcept {
-    const int term_degree = CTMath::sum(args...);
-    if(term_degree >= 0 && term_degree <= _degree) {
-      return get_coeff_idx_helper(term_degree, args...);
-    } else {
-      return DEGREE_RANGE_OVERFLOW;
-    }
-  }
-
-  template <typename int_t>
-  static int get_coeff_idx_helper(
-      int_t exp_left,
-      const Array<int_t, _dim> &exponents) noexcept {
-    int cur_sum = 0;
-    for(int i = 0; i < _dim - 1; ++i) {
-      int nck = _dim - i + exp_left - 1;
-      int term_1 =
-          nck * CTMath::n_choose_k(nck - 1, exp_left);
-      exp_left -= exponents[i];
-      int term_2 = (nck - exponents[i]) *
-                   CTMath::n_choose_k(
-                       nck - exponents[i] - 1, exp_left);
-      cur_sum += (term_1 - term_2) / (_dim - i - 1);
-    }
-    return cur_sum;
+  static int get_flat_idx(
+      const Array<int, _dim> &exponents) noexcept {
+    assert(CTMath::sum(exponents) >= 0);
+    assert(CTMath::sum(exponents) <= _degree);
+    const int idx = Utilities::term_index<_dim>(exponents);
+    assert(idx >= 0);
+    assert(idx < num_coeffs);
+    return idx;
   }
 
-  static constexpr const int num_coeffs =
-      Utilities::poly_degree_num_coeffs<int>(_degree, _dim);
   Array<CoeffT, num_coeffs> coeffs;
-
-  Polynomial<CoeffT, _degree - 1, _dim> lower_degree;
-
-  enum {
-    DEGREE_RANGE_UNDERFLOW = -1,
-    DEGREE_RANGE_OVERFLOW = -2,
-  };
 };
 
 template <typename CoeffT, int _dim>
@@ -398,6 +384,16 @@ class Polynomial<CoeffT, 0, _dim> {
 
   explicit Polynomial(const Tags::Zero_Tag &) : value(0) {}
 
+  template <typename OtherT>
+  explicit Polynomial(const Polynomial<OtherT, 0, _dim> &p)
+      : value(static_cast<CoeffT>(*p.data())) {}
+
+  static constexpr const int num_coeffs = 1;
+
+  CoeffT *data() noexcept { return &value; }
+
+  const CoeffT *data() const noexcept { return &value; }
+
   template <typename... int_list,
             typename std::enable_if<
                 sizeof...(int_list) == _dim, int>::type = 0>
@@ -547,24 +543,6 @@ class Polynomial<CoeffT, 0, _dim> {
     return reduced;
   }
 
-  template <typename... int_list,
-            typename std::enable_if<
-                sizeof...(int_list) == _dim, int>::type = 0>
-  static int get_coeff_idx(int_list... args) noexcept {
-    return CTMath::sum(args...) == 0
-               ? 0
-               : CTMath::sum(args...) > 0
-                     ? DEGREE_RANGE_OVERFLOW
-                     : DEGREE_RANGE_UNDERFLOW;
-  }
-
-  template <typename int_t, typename... int_list>
-  static int get_coeff_idx_helper(
-      int_t exp_left, int_t head,
-      int_list... args) noexcept {
-    return get_coeff_idx(head, args...);
-  }
-
   using Signature_Lambda =
       std::function<void(const Array<int, _dim> &)>;
 
@@ -577,13 +555,7 @@ class Polynomial<CoeffT, 0, _dim> {
   friend class Polynomial;
 
  private:
-  static constexpr const int num_coeffs = 1;
   CoeffT value;
-
-  enum {
-    DEGREE_RANGE_UNDERFLOW = -1,
-    DEGREE_RANGE_OVERFLOW = -2,
-  };
 };
 
 template <typename CoeffT, int _degree>
@@ -604,6 +576,12 @@ class Polynomial<CoeffT, _degree, 0> {
                   "must be zero");
   }
 
+  static constexpr const int num_coeffs = 1;
+
+  CoeffT *data() noexcept { return &value; }
+
+  const CoeffT *data() const noexcept { return &value; }
+
   CoeffT coeff() const noexcept { return value; }
 
   CoeffT &coeff() noexcept { return value; }
@@ -629,22 +607,7 @@ class Polynomial<CoeffT, _degree, 0> {
   friend class Polynomial;
 
  private:
-  static int get_coeff_idx() noexcept { return 0; }
-
-  static int get_coeff_idx_helper(int exp_left) noexcept {
-    return exp_left == 0
-               ? 0
-               : exp_left > 0 ? DEGREE_RANGE_OVERFLOW
-                              : DEGREE_RANGE_UNDERFLOW;
-  }
-
-  static constexpr const int num_coeffs = 1;
   CoeffT value;
-
-  enum {
-    DEGREE_RANGE_UNDERFLOW = -1,
-    DEGREE_RANGE_OVERFLOW = -2,
-  };
 };
 
 template <typename CoeffT, int _degree, int _dim>
@@ -0,0 +1,320 @@
+#ifndef _POLYNOMIAL_BATCH_HPP_
+#define _POLYNOMIAL_BATCH_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+#include <tags.hpp>
+
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+namespace Numerical {
+
+template <typename CoeffT, int _degree, int _dim>
+class PolynomialBatch;
+
+/* A single polynomial of a PolynomialBatch.
+ * It has Polynomial's coefficient accessors and eval, but
+ * the coefficients stay in the batch; use get() and set()
+ * (or conversion and assignment) to gather it into or
+ * scatter it from a Polynomial for anything else.
+ * BatchT is either the batch or a const batch
+ */
+template <typename BatchT>
+class PolynomialView {
+ public:
+  using CoeffT = typename BatchT::coeff_type;
+  using Poly = typename BatchT::Poly;
+  static constexpr const int dim = BatchT::dim;
+  static constexpr const int degree = BatchT::degree;
+
+  PolynomialView(BatchT &batch, int poly)
+      : batch(&batch), poly(poly) {
+    assert(poly >= 0);
+    assert(poly < batch.size());
+  }
+
+  int index() const noexcept { return poly; }
+
+  template <typename... int_list,
+            typename std::enable_if<
+                sizeof...(int_list) == dim, int>::type = 0>
+  auto &coeff(int_list... args) const noexcept {
+    return coeff(Array<int, dim>(args...));
+  }
+
+  auto &coeff(const Array<int, dim> &exponents) const
+      noexcept {
+    return batch->coeffs(
+        Utilities::term_index<dim>(exponents))[poly];
+  }
+
+  Poly get() const noexcept {
+    Poly p;
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      p.data()[k] = batch->coeffs(k)[poly];
+    }
+    return p;
+  }
+
+  void set(const Poly &p) const noexcept {
+    static_assert(!std::is_const<BatchT>::value,
+                  "Can't set a polynomial in a const "
+                  "batch");
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      batch->coeffs(k)[poly] = p.data()[k];
+    }
+  }
+
+  operator Poly() const noexcept { return get(); }
+
+  const PolynomialView &operator=(const Poly &p) const
+      noexcept {
+    set(p);
+    return *this;
+  }
+
+  template <typename... subs_list,
+            typename std::enable_if<
+                sizeof...(subs_list) == dim, int>::type = 0>
+  CoeffT eval(subs_list... vars) const noexcept {
+    return get().eval(vars...);
+  }
+
+ private:
+  BatchT *batch;
+  int poly;
+};
+
+/* Many polynomials of the same degree and dimension stored
+ * as a structure of arrays: coeffs(k) is coefficient k,
+ * in Polynomial::data() order, of every polynomial in the
+ * batch, so each kernel below is a set of loops over the
+ * batch which the compiler can vectorize, rather than one
+ * small loop per polynomial.
+ */
+template <typename CoeffT, int _degree, int _dim>
+class PolynomialBatch {
+ public:
+  using coeff_type = CoeffT;
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  using View = PolynomialView<PolynomialBatch>;
+  using ConstView = PolynomialView<const PolynomialBatch>;
+  static constexpr const int dim = _dim;
+  static constexpr const int degree = _degree;
+  static constexpr const int num_coeffs = Poly::num_coeffs;
+
+  PolynomialBatch() : count(0) {}
+
+  explicit PolynomialBatch(int size)
+      : count(size), values(size * num_coeffs) {
+    assert(size >= 0);
+  }
+
+  PolynomialBatch(int size, const Tags::Zero_Tag &)
+      : count(size),
+        values(size * num_coeffs,
+               CoeffTraits<CoeffT>::zero()) {
+    assert(size >= 0);
+  }
+
+  int size() const noexcept { return count; }
+
+  /* Coefficient k of every polynomial */
+  CoeffT *coeffs(int k) noexcept {
+    assert(k >= 0);
+    assert(k < num_coeffs);
+    return values.data() + k * count;
+  }
+
+  const CoeffT *coeffs(int k) const noexcept {
+    assert(k >= 0);
+    assert(k < num_coeffs);
+    return values.data() + k * count;
+  }
+
+  View operator[](int poly) noexcept {
+    return View(*this, poly);
+  }
+
+  ConstView operator[](int poly) const noexcept {
+    return ConstView(*this, poly);
+  }
+
+  PolynomialBatch operator+(
+      const PolynomialBatch &rhs) const {
+    assert(count == rhs.count);
+    PolynomialBatch s(count);
+    for(int i = 0; i < count * num_coeffs; i++) {
+      s.values[i] = values[i] + rhs.values[i];
+    }
+    return s;
+  }
+
+  PolynomialBatch operator-(
+      const PolynomialBatch &rhs) const {
+    assert(count == rhs.count);
+    PolynomialBatch s(count);
+    for(int i = 0; i < count * num_coeffs; i++) {
+      s.values[i] = values[i] - rhs.values[i];
+    }
+    return s;
+  }
+
+  PolynomialBatch operator*(const CoeffT &factor) const {
+    PolynomialBatch s(count);
+    for(int i = 0; i < count * num_coeffs; i++) {
+      s.values[i] = values[i] * factor;
+    }
+    return s;
+  }
+
+  /* Multiplies polynomial i by factors[i] */
+  PolynomialBatch scale(const CoeffT *factors) const {
+    PolynomialBatch s(count);
+    for(int k = 0; k < num_coeffs; k++) {
+      const CoeffT *src = coeffs(k);
+      CoeffT *dest = s.coeffs(k);
+      for(int i = 0; i < count; i++) {
+        dest[i] = src[i] * factors[i];
+      }
+    }
+    return s;
+  }
+
+  /* Multiplies every polynomial by m */
+  template <int other_degree>
+  PolynomialBatch<CoeffT, _degree + other_degree, _dim>
+  product(const Polynomial<CoeffT, other_degree, _dim> &m)
+      const {
+    PolynomialBatch<CoeffT, _degree + other_degree, _dim>
+        prod(count, Tags::Zero_Tag());
+    const std::vector<Array<int, _dim> > &terms =
+        Utilities::term_exponent_table<_degree, _dim>();
+    const std::vector<Array<int, _dim> > &other_terms =
+        Utilities::term_exponent_table<other_degree,
+                                       _dim>();
+    for(int j = 0; j < int(other_terms.size()); j++) {
+      const CoeffT factor = m.data()[j];
+      if(CoeffTraits<CoeffT>::is_zero(factor)) {
+        continue;
+      }
+      for(int k = 0; k < num_coeffs; k++) {
+        Array<int, _dim> exponents;
+        for(int d = 0; d < _dim; d++) {
+          exponents[d] = terms[k][d] + other_terms[j][d];
+        }
+        const CoeffT *src = coeffs(k);
+        CoeffT *dest =
+            prod.coeffs(Utilities::term_index(exponents));
+        for(int i = 0; i < count; i++) {
+          dest[i] = CoeffTraits<CoeffT>::fma(
+              src[i], factor, dest[i]);
+        }
+      }
+    }
+    return prod;
+  }
+
+  PolynomialBatch<CoeffT, _degree + 1, _dim> integrate(
+      int variable) const {
+    assert(variable >= 0);
+    assert(variable < _dim);
+    PolynomialBatch<CoeffT, _degree + 1, _dim> integral(
+        count, Tags::Zero_Tag());
+    const std::vector<Array<int, _dim> > &terms =
+        Utilities::term_exponent_table<_degree, _dim>();
+    for(int k = 0; k < num_coeffs; k++) {
+      Array<int, _dim> exponents(terms[k]);
+      exponents[variable]++;
+      const CoeffT factor =
+          CoeffTraits<CoeffT>::one() /
+          CoeffTraits<CoeffT>::broadcast(
+              exponents[variable]);
+      const CoeffT *src = coeffs(k);
+      CoeffT *dest =
+          integral.coeffs(Utilities::term_index(exponents));
+      for(int i = 0; i < count; i++) {
+        dest[i] = src[i] * factor;
+      }
+    }
+    return integral;
+  }
+
+  /* Constant batches differentiate to constant (zero)
+   * batches, as with the degree 0 Polynomial */
+  PolynomialBatch<CoeffT, (_degree > 0 ? _degree - 1 : 0),
+                  _dim>
+  differentiate(int variable) const {
+    assert(variable >= 0);
+    assert(variable < _dim);
+    PolynomialBatch<CoeffT, (_degree > 0 ? _degree - 1 : 0),
+                    _dim>
+        derivative(count, Tags::Zero_Tag());
+    const std::vector<Array<int, _dim> > &terms =
+        Utilities::term_exponent_table<_degree, _dim>();
+    for(int k = 0; k < num_coeffs; k++) {
+      Array<int, _dim> exponents(terms[k]);
+      if(exponents[variable] == 0) {
+        continue;
+      }
+      const CoeffT factor = CoeffTraits<CoeffT>::broadcast(
+          exponents[variable]);
+      exponents[variable]--;
+      const CoeffT *src = coeffs(k);
+      CoeffT *dest = derivative.coeffs(
+          Utilities::term_index(exponents));
+      for(int i = 0; i < count; i++) {
+        dest[i] = src[i] * factor;
+      }
+    }
+    return derivative;
+  }
+
+  /* Writes every polynomial evaluated at point to out.
+   * The monomials are evaluated once, and then accumulated
+   * one coefficient at a time across the batch */
+  void eval(const Array<CoeffT, _dim> &point,
+            CoeffT *out) const {
+    const std::vector<Array<int, _dim> > &terms =
+        Utilities::term_exponent_table<_degree, _dim>();
+    Array<Array<CoeffT, _degree + 1>, _dim> powers;
+    for(int d = 0; d < _dim; d++) {
+      powers[d][0] = CoeffTraits<CoeffT>::one();
+      for(int e = 1; e <= _degree; e++) {
+        powers[d][e] = powers[d][e - 1] * point[d];
+      }
+    }
+    for(int i = 0; i < count; i++) {
+      out[i] = CoeffTraits<CoeffT>::zero();
+    }
+    for(int k = 0; k < num_coeffs; k++) {
+      CoeffT m = CoeffTraits<CoeffT>::one();
+      for(int d = 0; d < _dim; d++) {
+        m = m * powers[d][terms[k][d]];
+      }
+      const CoeffT *src = coeffs(k);
+      for(int i = 0; i < count; i++) {
+        out[i] =
+            CoeffTraits<CoeffT>::fma(src[i], m, out[i]);
+      }
+    }
+  }
+
+ private:
+  int count;
+  std::vector<CoeffT> values;
+};
+
+template <typename CoeffT, int _degree, int _dim>
+PolynomialBatch<CoeffT, _degree, _dim> operator*(
+    const CoeffT &factor,
+    const PolynomialBatch<CoeffT, _degree, _dim> &b) {
+  return b * factor;
+}
+}  // namespace Numerical
+
+#endif  // _POLYNOMIAL_BATCH_HPP_
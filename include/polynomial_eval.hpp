@@ -0,0 +1,242 @@
+#ifndef _POLYNOMIAL_EVAL_HPP_
+#define _POLYNOMIAL_EVAL_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+/* Evaluates polynomials of a fixed degree at a fixed set
+ * of points.
+ * The value of every monomial at every point is computed
+ * once, so evaluating a polynomial at all of the points is
+ * a single matrix-vector product with its coefficients.
+ * The table is stored row-major by point, with the
+ * monomials in the order Polynomial::data() stores their
+ * coefficients, ie. it's the Vandermonde matrix of the
+ * points.
+ */
+template <typename CoeffT, int _degree, int _dim>
+class BatchEvaluator {
+ public:
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  static constexpr const int num_coeffs = Poly::num_coeffs;
+
+  BatchEvaluator() : npoints(0) {}
+
+  explicit BatchEvaluator(
+      const std::vector<Array<CoeffT, _dim> > &points)
+      : npoints(int(points.size())),
+        table(points.size() * num_coeffs) {
+    for(int p = 0; p < npoints; p++) {
+      monomials(points[p], &table[p * num_coeffs], 1);
+    }
+  }
+
+  /* Writes the values of the monomials at the point to
+   * dest[k * stride], so rows of other matrix layouts can
+   * be filled without building a table */
+  static void monomials(const Array<CoeffT, _dim> &point,
+                        CoeffT *dest, int stride) {
+    const std::vector<Array<int, _dim> > &terms =
+        Utilities::term_exponent_table<_degree, _dim>();
+    Array<Array<CoeffT, _degree + 1>, _dim> powers;
+    for(int d = 0; d < _dim; d++) {
+      powers[d][0] = CoeffTraits<CoeffT>::one();
+      for(int e = 1; e <= _degree; e++) {
+        powers[d][e] = powers[d][e - 1] * point[d];
+      }
+    }
+    for(int k = 0; k < num_coeffs; k++) {
+      CoeffT m = powers[0][terms[k][0]];
+      for(int d = 1; d < _dim; d++) {
+        m = m * powers[d][terms[k][d]];
+      }
+      dest[k * stride] = m;
+    }
+  }
+
+  int num_points() const noexcept { return npoints; }
+
+  /* The values of the monomials at the point */
+  const CoeffT *monomials(int point) const noexcept {
+    assert(point >= 0);
+    assert(point < npoints);
+    return &table[point * num_coeffs];
+  }
+
+  CoeffT eval(const Poly &p, int point) const noexcept {
+    const CoeffT *row = monomials(point);
+    const CoeffT *c = p.data();
+    CoeffT sum = row[0] * c[0];
+    for(int k = 1; k < num_coeffs; k++) {
+      sum = CoeffTraits<CoeffT>::fma(row[k], c[k], sum);
+    }
+    return sum;
+  }
+
+  /* Writes p evaluated at every point to out */
+  void eval(const Poly &p, CoeffT *out) const noexcept {
+    for(int pt = 0; pt < npoints; pt++) {
+      out[pt] = eval(p, pt);
+    }
+  }
+
+  /* Evaluates count polynomials at every point, writing
+   * the values for polys[i] to out[i * num_points()] */
+  void eval(const Poly *polys, int count, CoeffT *out) const
+      noexcept {
+    for(int i = 0; i < count; i++) {
+      eval(polys[i], out + i * npoints);
+    }
+  }
+
+ private:
+  int npoints;
+  std::vector<CoeffT> table;
+};
+
+namespace Internal {
+
+/* For each term of a polynomial of _dim variables in
+ * storage order, the exponent of its first variable and
+ * the index of the term its other variables form; fixing
+ * the first variable adds the term's coefficient into the
+ * coefficient at that index of the remaining polynomial.
+ * Built on the first call and cached, so the first call
+ * allocates */
+template <int _degree, int _dim>
+const std::vector<std::pair<int, int> > &
+first_variable_split() {
+  static const std::vector<std::pair<int, int> > split =
+      [] {
+        std::vector<std::pair<int, int> > s;
+        for(const Array<int, _dim> &e :
+            Utilities::term_exponents<_dim>(_degree)) {
+          Array<int, _dim - 1> rest;
+          for(int d = 1; d < _dim; d++) {
+            rest[d - 1] = e[d];
+          }
+          s.emplace_back(e[0], Utilities::term_index(rest));
+        }
+        return s;
+      }();
+  return split;
+}
+
+/* Evaluates the polynomial with the coefficients on the
+ * grid of the axes by fixing the first variable at each
+ * of its grid coordinates, and evaluating the polynomial
+ * of the remaining variables on the rest of the grid;
+ * scratch holds the coefficients of each level */
+template <typename CoeffT, int _degree, int _dim>
+struct GridEvaluator {
+  static void eval(const CoeffT *coeffs,
+                   const std::vector<CoeffT> *const *axes,
+                   std::vector<CoeffT> *scratch,
+                   CoeffT *out) {
+    const std::vector<std::pair<int, int> > &split =
+        first_variable_split<_degree, _dim>();
+    constexpr const int num_coeffs =
+        Utilities::poly_num_coeffs<int>(_degree, _dim);
+    constexpr const int sliced_coeffs =
+        Utilities::poly_num_coeffs<int>(_degree, _dim - 1);
+    int block = 1;
+    for(int d = 1; d < _dim; d++) {
+      block *= int(axes[d]->size());
+    }
+    CoeffT *sliced = scratch->data();
+    for(int i = 0; i < int(axes[0]->size()); i++) {
+      Array<CoeffT, _degree + 1> powers;
+      powers[0] = CoeffTraits<CoeffT>::one();
+      for(int e = 1; e <= _degree; e++) {
+        powers[e] = powers[e - 1] * (*axes[0])[i];
+      }
+      for(int k = 0; k < sliced_coeffs; k++) {
+        sliced[k] = CoeffTraits<CoeffT>::zero();
+      }
+      for(int k = 0; k < num_coeffs; k++) {
+        CoeffT &dest = sliced[split[k].second];
+        dest = CoeffTraits<CoeffT>::fma(
+            coeffs[k], powers[split[k].first], dest);
+      }
+      GridEvaluator<CoeffT, _degree, _dim - 1>::eval(
+          sliced, axes + 1, scratch + 1, out + i * block);
+    }
+  }
+};
+
+/* 1D polynomials store the coefficient of x^k at k */
+template <typename CoeffT, int _degree>
+struct GridEvaluator<CoeffT, _degree, 1> {
+  static void eval(const CoeffT *coeffs,
+                   const std::vector<CoeffT> *const *axes,
+                   std::vector<CoeffT> *,
+                   CoeffT *out) noexcept {
+    const std::vector<CoeffT> &xs = *axes[0];
+    for(int i = 0; i < int(xs.size()); i++) {
+      CoeffT sum = coeffs[_degree];
+      for(int k = _degree - 1; k >= 0; k--) {
+        sum =
+            CoeffTraits<CoeffT>::fma(sum, xs[i], coeffs[k]);
+      }
+      out[i] = sum;
+    }
+  }
+};
+
+template <typename CoeffT, int _degree, int _dim>
+void eval_grid(const Polynomial<CoeffT, _degree, _dim> &p,
+               const std::vector<CoeffT> *const *axes,
+               CoeffT *out) {
+  std::vector<std::vector<CoeffT> > scratch;
+  for(int d = _dim - 1; d > 0; d--) {
+    scratch.emplace_back(
+        Utilities::poly_num_coeffs<int>(_degree, d));
+  }
+  GridEvaluator<CoeffT, _degree, _dim>::eval(
+      p.data(), axes, scratch.data(), out);
+}
+}  // namespace Internal
+
+/* Evaluates p at every point of the tensor grid
+ * axes[0] x axes[1] x ..., with the last axis varying
+ * fastest in out.
+ * The variables are fixed one at a time, so the partial
+ * evaluations are shared by every grid line through them;
+ * for n points on each axis this costs
+ * O(n p^_dim + n^2 p^(_dim - 1) + ... + n^_dim p) for the
+ * p^_dim coefficients rather than n^_dim full evaluations.
+ */
+template <typename CoeffT, int _degree, int _dim>
+void eval_grid(
+    const Polynomial<CoeffT, _degree, _dim> &p,
+    const std::vector<std::vector<CoeffT> > &axes,
+    CoeffT *out) {
+  assert(int(axes.size()) == _dim);
+  Array<const std::vector<CoeffT> *, _dim> axis_ptrs;
+  for(int d = 0; d < _dim; d++) {
+    axis_ptrs[d] = &axes[d];
+  }
+  Internal::eval_grid(p, axis_ptrs.data, out);
+}
+
+/* out[(i ys.size() + j) zs.size() + k] is
+ * p(xs[i], ys[j], zs[k]) */
+template <typename CoeffT, int _degree>
+void eval_grid(const Polynomial<CoeffT, _degree, 3> &p,
+               const std::vector<CoeffT> &xs,
+               const std::vector<CoeffT> &ys,
+               const std::vector<CoeffT> &zs, CoeffT *out) {
+  const std::vector<CoeffT> *axes[] = {&xs, &ys, &zs};
+  Internal::eval_grid(p, axes, out);
+}
+}  // namespace Numerical
+
+#endif  // _POLYNOMIAL_EVAL_HPP_
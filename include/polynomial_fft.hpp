@@ -0,0 +1,258 @@
+#ifndef _POLYNOMIAL_FFT_HPP_
+#define _POLYNOMIAL_FFT_HPP_
+
+#include <array.hpp>
+#include <ctmath.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+namespace Internal {
+
+constexpr int fft_size(long long min_size) noexcept {
+  int n = 1;
+  while(n < min_size) {
+    n *= 2;
+  }
+  return n;
+}
+
+constexpr int fft_log2(int n) noexcept {
+  int l = 0;
+  while((1 << l) < n) {
+    l++;
+  }
+  return l;
+}
+
+/* exp(-2 pi i k / n) for k in [0, n / 2); built on the
+ * first call and cached */
+template <typename RealT, int n>
+const std::vector<std::complex<RealT> > &fft_twiddles() {
+  static const std::vector<std::complex<RealT> > twiddles =
+      [] {
+        const RealT pi = std::acos(RealT(-1));
+        std::vector<std::complex<RealT> > w(n / 2);
+        for(int k = 0; k < n / 2; k++) {
+          w[k] = std::polar(RealT(1), -2 * pi * k / n);
+        }
+        return w;
+      }();
+  return twiddles;
+}
+
+/* In place iterative radix 2 FFT; the inverse isn't
+ * scaled by 1 / n */
+template <typename RealT, int n>
+void fft(std::complex<RealT> *data, bool inverse) {
+  static_assert(n > 0 && (n & (n - 1)) == 0,
+                "The FFT size must be a power of 2");
+  for(int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for(; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if(i < j) {
+      std::swap(data[i], data[j]);
+    }
+  }
+  const std::vector<std::complex<RealT> > &twiddles =
+      fft_twiddles<RealT, n>();
+  for(int len = 2; len <= n; len *= 2) {
+    const int half = len / 2;
+    const int stride = n / len;
+    for(int start = 0; start < n; start += len) {
+      for(int j = 0; j < half; j++) {
+        const std::complex<RealT> w =
+            inverse ? std::conj(twiddles[j * stride])
+                    : twiddles[j * stride];
+        const std::complex<RealT> u = data[start + j];
+        const std::complex<RealT> v =
+            data[start + j + half] * w;
+        data[start + j] = u + v;
+        data[start + j + half] = u - v;
+      }
+    }
+  }
+}
+
+/* The index of each term of a polynomial of degree
+ * _degree in storage order after Kronecker substitution,
+ * x_0^e_0 x_1^e_1 ... -> t^(e_0 + e_1 base + ...).
+ * Exponents of a product of degree < base can't carry
+ * into the next variable, so multiplying the univariate
+ * polynomials gives the multivariate product.
+ * They're built on the first call and cached */
+template <int _degree, int _dim, int base>
+const std::vector<int> &kronecker_indices() {
+  static const std::vector<int> indices = [] {
+    std::vector<int> idx;
+    for(const Array<int, _dim> &e :
+        Utilities::term_exponents<_dim>(_degree)) {
+      int k = 0;
+      for(int d = _dim - 1; d >= 0; d--) {
+        k = k * base + e[d];
+      }
+      idx.push_back(k);
+    }
+    return idx;
+  }();
+  return indices;
+}
+
+/* The length of the substituted product of degree
+ * _degree; its highest power is _degree base^(_dim - 1) */
+template <int _degree, int _dim>
+constexpr long long kronecker_length() noexcept {
+  return _degree * CTMath::power<long long>(_degree + 1,
+                                            _dim - 1) +
+         1;
+}
+
+/* use_fft_product's cost model: a dense product costs
+ * dense_cost_factor dim na nb and an FFT product costs
+ * n (log2(n) + 1), where na and nb are the numbers of
+ * coefficients and n is the FFT length; the dense
+ * product's cost per term grows with dim since it looks
+ * up each coefficient by its exponents.
+ * Fit to src/bench/product_bench.cpp: over equal, half and
+ * linear second degrees up to 16 in 1 to 3 dimensions,
+ * the model picks the faster product except near the
+ * crossover of 3D products with a linear factor, where
+ * the timings are within noise and it loses up to 60% */
+constexpr const int dense_cost_factor = 7;
+}  // namespace Internal
+
+/* Whether fast_product multiplies polynomials of these
+ * degrees with the FFT; only floating point coefficients
+ * can use it, and ties go to the dense product, which
+ * rounds each term once */
+template <typename CoeffT, int _degree, int other_degree,
+          int _dim>
+constexpr bool use_fft_product() noexcept {
+  const long long n = Internal::fft_size(
+      Internal::kronecker_length<_degree + other_degree,
+                                 _dim>());
+  const long long fft_cost =
+      n * (Internal::fft_log2(n) + 1);
+  const long long dense_cost =
+      static_cast<long long>(Internal::dense_cost_factor) *
+      _dim * Polynomial<CoeffT, _degree, _dim>::num_coeffs *
+      Polynomial<CoeffT, other_degree, _dim>::num_coeffs;
+  return std::is_floating_point<CoeffT>::value &&
+         fft_cost < dense_cost;
+}
+
+/* Computes p * q with Kronecker substitution and an FFT,
+ * in O(n log(n)) for the n = O((degree + 1)^_dim) length
+ * of the substituted product.
+ * Both real inputs are transformed at once as the real
+ * and imaginary parts of one complex FFT, so a product
+ * costs one forward and one inverse transform.
+ * The result is rounded like any floating point
+ * convolution, with errors relative to the largest terms
+ */
+template <typename CoeffT, int _degree, int other_degree,
+          int _dim>
+Polynomial<CoeffT, _degree + other_degree, _dim>
+fft_product(
+    const Polynomial<CoeffT, _degree, _dim> &p,
+    const Polynomial<CoeffT, other_degree, _dim> &q) {
+  static_assert(std::is_floating_point<CoeffT>::value,
+                "The FFT product needs floating point "
+                "coefficients");
+  constexpr const int prod_degree = _degree + other_degree;
+  constexpr const int base = prod_degree + 1;
+  static_assert(Internal::kronecker_length<prod_degree,
+                                           _dim>() <=
+                    (1 << 30),
+                "The substituted product is too long");
+  constexpr const int n = Internal::fft_size(
+      Internal::kronecker_length<prod_degree, _dim>());
+  using Complex = std::complex<CoeffT>;
+  using FP = Polynomial<CoeffT, prod_degree, _dim>;
+
+  std::vector<Complex> z(n, Complex(0, 0));
+  const std::vector<int> &p_idx =
+      Internal::kronecker_indices<_degree, _dim, base>();
+  for(int k = 0; k < p.num_coeffs; k++) {
+    z[p_idx[k]].real(p.data()[k]);
+  }
+  const std::vector<int> &q_idx =
+      Internal::kronecker_indices<other_degree, _dim,
+                                  base>();
+  for(int k = 0; k < q.num_coeffs; k++) {
+    z[q_idx[k]].imag(q.data()[k]);
+  }
+  Internal::fft<CoeffT, n>(z.data(), false);
+  /* With Z = FFT(p + i q), P_k = (Z_k + conj(Z_-k)) / 2
+   * and Q_k = (Z_k - conj(Z_-k)) / 2i, so
+   * P_k Q_k = (Z_k^2 - conj(Z_-k)^2) / 4i */
+  std::vector<Complex> prod(n);
+  for(int k = 0; k < n; k++) {
+    const Complex zk = z[k];
+    const Complex zn = std::conj(z[(n - k) & (n - 1)]);
+    prod[k] = (zk * zk - zn * zn) * Complex(0, -0.25);
+  }
+  Internal::fft<CoeffT, n>(prod.data(), true);
+  FP result;
+  const std::vector<int> &r_idx =
+      Internal::kronecker_indices<prod_degree, _dim,
+                                  base>();
+  for(int k = 0; k < result.num_coeffs; k++) {
+    result.data()[k] = prod[r_idx[k]].real() / n;
+  }
+  return result;
+}
+
+namespace Internal {
+
+template <typename CoeffT, int _degree, int other_degree,
+          int _dim>
+Polynomial<CoeffT, _degree + other_degree, _dim>
+fast_product(
+    const Polynomial<CoeffT, _degree, _dim> &p,
+    const Polynomial<CoeffT, other_degree, _dim> &q,
+    std::true_type) {
+  return fft_product(p, q);
+}
+
+template <typename CoeffT, int _degree, int other_degree,
+          int _dim>
+Polynomial<CoeffT, _degree + other_degree, _dim>
+fast_product(
+    const Polynomial<CoeffT, _degree, _dim> &p,
+    const Polynomial<CoeffT, other_degree, _dim> &q,
+    std::false_type) {
+  return p.product(q);
+}
+}  // namespace Internal
+
+/* Computes p * q with whichever of Polynomial::product and
+ * fft_product is expected to be faster for these degrees;
+ * the choice is made at compile time by use_fft_product */
+template <typename CoeffT, int _degree, int other_degree,
+          int _dim>
+Polynomial<CoeffT, _degree + other_degree, _dim>
+fast_product(
+    const Polynomial<CoeffT, _degree, _dim> &p,
+    const Polynomial<CoeffT, other_degree, _dim> &q) {
+  return Internal::fast_product(
+      p, q,
+      std::integral_constant<
+          bool, use_fft_product<CoeffT, _degree,
+                                other_degree, _dim>()>());
+}
+}  // namespace Numerical
+
+#endif  // _POLYNOMIAL_FFT_HPP_
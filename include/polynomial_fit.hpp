@@ -0,0 +1,264 @@
+#ifndef _POLYNOMIAL_FIT_HPP_
+#define _POLYNOMIAL_FIT_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <parallel.hpp>
+#include <polynomial.hpp>
+#include <polynomial_eval.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace Numerical {
+
+namespace Internal {
+
+/* Keeps a parameter out of template argument deduction, so
+ * defaulted pointers can be passed nullptr */
+template <typename T>
+using NonDeduced = typename std::common_type<T>::type;
+
+/* Solves the least squares problem min |A x - b| with
+ * Householder QR, overwriting A (rows x cols, column major,
+ * rows >= cols) and b.
+ * Returns false if A doesn't have full column rank, ie.
+ * if a diagonal entry of R is at most
+ * epsilon rows max_k |A e_k|, which is the rounding error
+ * of the factorization */
+template <typename CoeffT>
+bool householder_solve(CoeffT *A, int rows, int cols,
+                       CoeffT *b, CoeffT *x) noexcept {
+  using std::sqrt;
+  assert(rows >= cols);
+  const CoeffT zero = CoeffTraits<CoeffT>::zero();
+  CoeffT max_norm_sq = zero;
+  for(int k = 0; k < cols; k++) {
+    const CoeffT *col = A + k * rows;
+    CoeffT norm_sq = zero;
+    for(int i = 0; i < rows; i++) {
+      norm_sq = CoeffTraits<CoeffT>::fma(col[i], col[i],
+                                         norm_sq);
+    }
+    if(max_norm_sq < norm_sq) {
+      max_norm_sq = norm_sq;
+    }
+  }
+  const CoeffT tolerance =
+      std::numeric_limits<CoeffT>::epsilon() *
+      CoeffTraits<CoeffT>::broadcast(rows) *
+      sqrt(max_norm_sq);
+  for(int k = 0; k < cols; k++) {
+    CoeffT *col = A + k * rows;
+    CoeffT norm_sq = zero;
+    for(int i = k; i < rows; i++) {
+      norm_sq = CoeffTraits<CoeffT>::fma(col[i], col[i],
+                                         norm_sq);
+    }
+    if(CoeffTraits<CoeffT>::is_zero(norm_sq)) {
+      return false;
+    }
+    /* Reflect onto -sign(a_kk) |a| e_k to avoid
+     * cancellation; v = a - alpha e_k is stored in place */
+    const CoeffT norm = sqrt(norm_sq);
+    if(norm <= tolerance) {
+      return false;
+    }
+    const CoeffT alpha = col[k] < zero ? norm : -norm;
+    const CoeffT vk = col[k] - alpha;
+    /* v^T v = 2 (norm^2 - alpha a_kk) */
+    const CoeffT beta = norm_sq - alpha * col[k];
+    col[k] = vk;
+    for(int j = k + 1; j < cols; j++) {
+      CoeffT *other = A + j * rows;
+      CoeffT dot = zero;
+      for(int i = k; i < rows; i++) {
+        dot =
+            CoeffTraits<CoeffT>::fma(col[i], other[i], dot);
+      }
+      const CoeffT f = dot / beta;
+      for(int i = k; i < rows; i++) {
+        other[i] = other[i] - f * col[i];
+      }
+    }
+    CoeffT dot = zero;
+    for(int i = k; i < rows; i++) {
+      dot = CoeffTraits<CoeffT>::fma(col[i], b[i], dot);
+    }
+    const CoeffT f = dot / beta;
+    for(int i = k; i < rows; i++) {
+      b[i] = b[i] - f * col[i];
+    }
+    /* R's diagonal */
+    col[k] = alpha;
+  }
+  for(int k = cols - 1; k >= 0; k--) {
+    CoeffT sum = b[k];
+    for(int j = k + 1; j < cols; j++) {
+      sum = sum - A[j * rows + k] * x[j];
+    }
+    x[k] = sum / A[k * rows + k];
+  }
+  return true;
+}
+
+/* The number of rows of the fit's least squares system */
+template <typename Poly>
+int fit_rows(int num_samples, bool ridge) noexcept {
+  return num_samples + (ridge ? Poly::num_coeffs : 0);
+}
+
+/* Fills A and b for the fit, with the rows of A scaled by
+ * the square roots of the weights, followed by the ridge
+ * rows sqrt(ridge) I.
+ * The monomials are written straight into A's rows, so
+ * nothing is allocated besides the cached exponent table */
+template <typename CoeffT, int _degree, int _dim>
+void fit_system(
+    const std::vector<Array<CoeffT, _dim> > &points,
+    const CoeffT *values, const CoeffT *weights,
+    const CoeffT &ridge, CoeffT *A, CoeffT *b) {
+  using std::sqrt;
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  constexpr const int cols = Poly::num_coeffs;
+  const int num_samples = int(points.size());
+  const bool regularized =
+      !CoeffTraits<CoeffT>::is_zero(ridge);
+  const int rows = fit_rows<Poly>(num_samples, regularized);
+  for(int i = 0; i < num_samples; i++) {
+    BatchEvaluator<CoeffT, _degree, _dim>::monomials(
+        points[i], A + i, rows);
+    if(weights == nullptr) {
+      b[i] = values[i];
+      continue;
+    }
+    const CoeffT scale = sqrt(weights[i]);
+    for(int k = 0; k < cols; k++) {
+      A[k * rows + i] = scale * A[k * rows + i];
+    }
+    b[i] = scale * values[i];
+  }
+  if(regularized) {
+    const CoeffT diag = sqrt(ridge);
+    for(int k = 0; k < cols; k++) {
+      for(int i = num_samples; i < rows; i++) {
+        A[k * rows + i] = i - num_samples == k
+                              ? diag
+                              : CoeffTraits<CoeffT>::zero();
+      }
+      b[num_samples + k] = CoeffTraits<CoeffT>::zero();
+    }
+  }
+}
+}  // namespace Internal
+
+/* Fits p to the samples (points[i], values[i]) in the
+ * least squares sense, minimizing
+ * sum_i weights[i] (p(points[i]) - values[i])^2 +
+ *   ridge |coefficients|^2.
+ * The Vandermonde rows come from BatchEvaluator, so the
+ * columns are in p's coefficient order and the
+ * solution is written straight to p.
+ * Returns false, leaving p unchanged, if the samples don't
+ * determine p to within rounding error; a positive ridge
+ * which isn't negligible next to the samples prevents
+ * that.
+ */
+template <typename CoeffT, int _degree, int _dim>
+bool least_squares_fit(
+    const std::vector<Array<CoeffT, _dim> > &points,
+    const CoeffT *values,
+    Polynomial<CoeffT, _degree, _dim> &p,
+    const Internal::NonDeduced<CoeffT> *weights = nullptr,
+    const CoeffT &ridge = CoeffTraits<CoeffT>::zero()) {
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  const int rows = Internal::fit_rows<Poly>(
+      int(points.size()),
+      !CoeffTraits<CoeffT>::is_zero(ridge));
+  if(rows < Poly::num_coeffs) {
+    return false;
+  }
+  std::vector<CoeffT> A(rows * Poly::num_coeffs);
+  std::vector<CoeffT> b(rows);
+  Array<CoeffT, Poly::num_coeffs> x;
+  Internal::fit_system<CoeffT, _degree, _dim>(
+      points, values, weights, ridge, A.data(), b.data());
+  if(!Internal::householder_solve(
+         A.data(), rows, Poly::num_coeffs, b.data(),
+         x.data)) {
+    return false;
+  }
+  for(int k = 0; k < Poly::num_coeffs; k++) {
+    p.data()[k] = x[k];
+  }
+  return true;
+}
+
+/* Fits out[s] to the samples (point_sets[s], value_sets[s])
+ * for every set s in parallel, with the weights in
+ * weight_sets[s] when it's given.
+ * The least squares systems are built in the threads'
+ * scratch arenas.
+ * Returns the number of sets which couldn't be fit; their
+ * polynomials are left unchanged.
+ */
+template <typename CoeffT, int _degree, int _dim>
+int least_squares_fit(
+    Parallel::Scheduler &sched,
+    const std::vector<std::vector<Array<CoeffT, _dim> > >
+        &point_sets,
+    const std::vector<std::vector<CoeffT> > &value_sets,
+    Polynomial<CoeffT, _degree, _dim> *out,
+    const Internal::NonDeduced<
+        std::vector<std::vector<CoeffT> > > *weight_sets =
+        nullptr,
+    const CoeffT &ridge = CoeffTraits<CoeffT>::zero()) {
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  assert(point_sets.size() == value_sets.size());
+  assert(weight_sets == nullptr ||
+         weight_sets->size() == point_sets.size());
+  const bool regularized =
+      !CoeffTraits<CoeffT>::is_zero(ridge);
+  return sched.reduce(
+      0, int(point_sets.size()), 0,
+      [&](int s, int thread) {
+        const int rows = Internal::fit_rows<Poly>(
+            int(point_sets[s].size()), regularized);
+        if(rows < Poly::num_coeffs) {
+          return 1;
+        }
+        Parallel::ScratchArena &arena =
+            sched.arena(thread);
+        CoeffT *A = static_cast<CoeffT *>(arena.allocate(
+            sizeof(CoeffT) * rows * Poly::num_coeffs,
+            alignof(CoeffT)));
+        CoeffT *b = static_cast<CoeffT *>(
+            arena.allocate(sizeof(CoeffT) * rows,
+                           alignof(CoeffT)));
+        Internal::fit_system<CoeffT, _degree, _dim>(
+            point_sets[s], value_sets[s].data(),
+            weight_sets != nullptr
+                ? (*weight_sets)[s].data()
+                : nullptr,
+            ridge, A, b);
+        Array<CoeffT, Poly::num_coeffs> x;
+        const bool solved = Internal::householder_solve(
+            A, rows, Poly::num_coeffs, b, x.data);
+        arena.reset();
+        if(!solved) {
+          return 1;
+        }
+        for(int k = 0; k < Poly::num_coeffs; k++) {
+          out[s].data()[k] = x[k];
+        }
+        return 0;
+      },
+      [](int a, int b) { return a + b; },
+      Parallel::Reduction::Deterministic, 1);
+}
+}  // namespace Numerical
+
+#endif  // _POLYNOMIAL_FIT_HPP_
@@ -0,0 +1,216 @@
+#ifndef _POLYNOMIAL_INTEGRATE_HPP_
+#define _POLYNOMIAL_INTEGRATE_HPP_
+
+#include <affine_map.hpp>
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+namespace Internal {
+
+/* Sums the coefficients of the terms of degree exp_left +
+ * the degree of scale's term, each multiplied by the
+ * product of the 1D moments of its exponents; idx is the
+ * index of the next coefficient in storage order */
+template <typename CoeffT, int _degree, int _dim>
+CoeffT moment_sum(
+    const CoeffT *coeffs, int &idx, int cur_dim,
+    int exp_left, const CoeffT &scale,
+    const Array<Array<CoeffT, _degree + 1>, _dim> &moments)
+    noexcept {
+  if(cur_dim == _dim - 1) {
+    return coeffs[idx++] * scale *
+           moments[cur_dim][exp_left];
+  }
+  CoeffT sum = CoeffTraits<CoeffT>::zero();
+  for(int e = 0; e <= exp_left; e++) {
+    sum = sum + moment_sum<CoeffT, _degree, _dim>(
+                    coeffs, idx, cur_dim + 1, exp_left - e,
+                    scale * moments[cur_dim][e], moments);
+  }
+  return sum;
+}
+}  // namespace Internal
+
+/* Computes the integral of p over the box [lo, hi].
+ * Monomials are separable, so the integral of a term is
+ * its coefficient times the product of the 1D integrals
+ * of each variable's power, which are tabulated once;
+ * this is O(num_coeffs) and doesn't build the
+ * antiderivative.
+ */
+template <typename CoeffT, int _degree, int _dim>
+CoeffT integrate_box(
+    const Polynomial<CoeffT, _degree, _dim> &p,
+    const Array<CoeffT, _dim> &lo,
+    const Array<CoeffT, _dim> &hi) noexcept {
+  static_assert(_dim > 0,
+                "Can't integrate over a 0 dimensional box");
+  /* moments[d][e] is the integral of x_d^e over
+   * [lo[d], hi[d]] */
+  Array<Array<CoeffT, _degree + 1>, _dim> moments;
+  for(int d = 0; d < _dim; d++) {
+    CoeffT lo_pow = lo[d];
+    CoeffT hi_pow = hi[d];
+    for(int e = 0; e <= _degree; e++) {
+      moments[d][e] = (hi_pow - lo_pow) /
+                      CoeffTraits<CoeffT>::broadcast(e + 1);
+      lo_pow = lo_pow * lo[d];
+      hi_pow = hi_pow * hi[d];
+    }
+  }
+  int idx = 0;
+  CoeffT integral = CoeffTraits<CoeffT>::zero();
+  for(int term_degree = 0; term_degree <= _degree;
+      term_degree++) {
+    integral =
+        integral +
+        Internal::moment_sum<CoeffT, _degree, _dim>(
+            p.data(), idx, 0, term_degree,
+            CoeffTraits<CoeffT>::one(), moments);
+  }
+  assert(idx == p.num_coeffs);
+  return integral;
+}
+
+/* The integrals of every monomial of up to degree _degree
+ * over a simplex, in Polynomial's coefficient order.
+ * They're computed by mapping the reference simplex,
+ * where the integral of x^a is a! / (|a| + _dim)!, onto
+ * the simplex, which costs O(num_coeffs^2) once; then the
+ * integral of each polynomial over the simplex is a
+ * O(num_coeffs) dot product with the moments.
+ */
+template <typename CoeffT, int _degree, int _dim>
+class SimplexMoments {
+ public:
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  using Vertices = Array<Array<CoeffT, _dim>, _dim + 1>;
+  static constexpr const int num_coeffs = Poly::num_coeffs;
+
+  static_assert(_dim > 0,
+                "Can't integrate over a 0 dimensional "
+                "simplex");
+
+  explicit SimplexMoments(const Vertices &vertices)
+      : moment_table(num_coeffs) {
+    /* x = J lambda + v_0, where the columns of J are the
+     * edges from v_0 */
+    typename AffineMap<CoeffT, _degree, _dim>::Matrix J;
+    for(int i = 0; i < _dim; i++) {
+      for(int j = 0; j < _dim; j++) {
+        J[i][j] = vertices[j + 1][i] - vertices[0][i];
+      }
+    }
+    const CoeffT volume = abs_determinant(J);
+    const AffineMap<CoeffT, _degree, _dim> map(J,
+                                               vertices[0]);
+    const std::vector<Array<int, _dim> > terms =
+        Utilities::term_exponents<_dim>(_degree);
+    std::vector<CoeffT> reference(num_coeffs);
+    for(int k = 0; k < num_coeffs; k++) {
+      reference[k] = reference_moment(terms[k]);
+    }
+    for(int k = 0; k < num_coeffs; k++) {
+      const CoeffT *col = map.column(k);
+      const int rows = Utilities::poly_num_coeffs(
+          Utilities::basis_degree(k, _dim), _dim);
+      CoeffT m = CoeffTraits<CoeffT>::zero();
+      for(int i = 0; i < rows; i++) {
+        m = CoeffTraits<CoeffT>::fma(col[i], reference[i],
+                                     m);
+      }
+      moment_table[k] = volume * m;
+    }
+  }
+
+  /* The integral of monomial k over the simplex */
+  const CoeffT &moment(int k) const noexcept {
+    assert(k >= 0);
+    assert(k < num_coeffs);
+    return moment_table[k];
+  }
+
+  CoeffT integrate(const Poly &p) const noexcept {
+    CoeffT integral = CoeffTraits<CoeffT>::zero();
+    for(int k = 0; k < num_coeffs; k++) {
+      integral = CoeffTraits<CoeffT>::fma(
+          p.data()[k], moment_table[k], integral);
+    }
+    return integral;
+  }
+
+ private:
+  /* a! / (|a| + _dim)! */
+  static CoeffT reference_moment(
+      const Array<int, _dim> &exponents) noexcept {
+    CoeffT m = CoeffTraits<CoeffT>::one();
+    int denom = 1;
+    for(int d = 0; d < _dim; d++) {
+      for(int i = 1; i <= exponents[d]; i++) {
+        m = m * CoeffTraits<CoeffT>::broadcast(i) /
+            CoeffTraits<CoeffT>::broadcast(denom);
+        denom++;
+      }
+    }
+    for(int d = 0; d < _dim; d++) {
+      m = m / CoeffTraits<CoeffT>::broadcast(denom);
+      denom++;
+    }
+    return m;
+  }
+
+  /* Gaussian elimination with partial pivoting */
+  static CoeffT abs_determinant(
+      typename AffineMap<CoeffT, _degree, _dim>::Matrix J)
+      noexcept {
+    const CoeffT zero = CoeffTraits<CoeffT>::zero();
+    auto magnitude = [&](const CoeffT &v) {
+      return v < zero ? -v : v;
+    };
+    CoeffT det = CoeffTraits<CoeffT>::one();
+    for(int c = 0; c < _dim; c++) {
+      int pivot = c;
+      for(int r = c + 1; r < _dim; r++) {
+        if(magnitude(J[pivot][c]) < magnitude(J[r][c])) {
+          pivot = r;
+        }
+      }
+      if(CoeffTraits<CoeffT>::is_zero(J[pivot][c])) {
+        return zero;
+      }
+      std::swap(J[c], J[pivot]);
+      det = det * J[c][c];
+      for(int r = c + 1; r < _dim; r++) {
+        const CoeffT f = J[r][c] / J[c][c];
+        for(int j = c; j < _dim; j++) {
+          J[r][j] = J[r][j] - f * J[c][j];
+        }
+      }
+    }
+    return magnitude(det);
+  }
+
+  std::vector<CoeffT> moment_table;
+};
+
+/* Computes the integral of p over the simplex with the
+ * vertices; use a SimplexMoments to integrate many
+ * polynomials over the same simplex */
+template <typename CoeffT, int _degree, int _dim>
+CoeffT integrate_simplex(
+    const Polynomial<CoeffT, _degree, _dim> &p,
+    const Array<Array<CoeffT, _dim>, _dim + 1> &vertices) {
+  return SimplexMoments<CoeffT, _degree, _dim>(vertices)
+      .integrate(p);
+}
+}  // namespace Numerical
+
+#endif  // _POLYNOMIAL_INTEGRATE_HPP_
@@ -2,9 +2,13 @@
 #ifndef _POLYNOMIAL_UTILS_HPP_
 #define _POLYNOMIAL_UTILS_HPP_
 
+#include <functional>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include <ctmath.hpp>
+#include <field.hpp>
 
 namespace Numerical {
 
@@ -14,10 +18,13 @@ class Polynomial;
 namespace Utilities {
 
 // Returns the total number of coefficients required to
-// represent polynomials of the specified degree
+// represent polynomials of the specified degree.
+// These counts and indices come from CTMath::n_choose_k,
+// so like it they throw std::overflow_error when they
+// don't fit in int_t, rather than being noexcept
 template <typename int_t>
 constexpr int_t poly_num_coeffs(int_t degree_range,
-                                int_t dim) noexcept {
+                                int_t dim) {
   return CTMath::n_choose_k<int_t>(dim + degree_range, dim);
 }
 
@@ -26,45 +33,41 @@ constexpr int_t poly_num_coeffs(int_t degree_range,
 // specified degree
 template <typename int_t>
 constexpr int_t poly_degree_num_coeffs(int_t degree,
-                                       int_t dim) noexcept {
+                                       int_t dim) {
   return CTMath::n_choose_k<int_t>(dim + degree - 1,
                                    degree);
 }
 
-// A TMP for deducing the tuple type required to represent a
-// basis of the specified degree
+// Returns the degree of the basis function at index in a
+// basis ordered by increasing degree, ie. the smallest
+// degree with more than index coefficients
+template <typename int_t>
+constexpr int_t basis_degree(int_t index, int_t dim) {
+  int_t degree = 0;
+  while(index >= poly_num_coeffs(degree, dim)) {
+    degree++;
+  }
+  return degree;
+}
+
+// Deduces the tuple type required to represent a basis of
+// the specified degree
 // Starts with degree 0 and continues in increasing order
+// The element types are expanded from one index pack, so
+// the instantiation depth doesn't grow with the basis size
 template <typename CoeffT, int _max_degree, int _dim,
-          int _index = 1,
-          int _remaining_degree = _max_degree,
-          typename... poly_pack>
-class basis_tuple {
- public:
-  static constexpr int current_degree =
-      _max_degree - _remaining_degree;
-  using poly_type =
-      Polynomial<CoeffT, current_degree, _dim>;
-
-  using next =
-      basis_tuple<CoeffT, _max_degree, _dim, _index + 1,
-                  _index >= poly_num_coeffs(current_degree,
-                                            _dim)
-                      ? _remaining_degree - 1
-                      : _remaining_degree,
-                  poly_pack..., poly_type>;
-
-  using tuple_type = typename next::tuple_type;
-};
+          typename _indices = std::make_integer_sequence<
+              int, poly_num_coeffs(_max_degree, _dim)> >
+class basis_tuple;
 
 template <typename CoeffT, int _max_degree, int _dim,
-          int _index, typename... poly_pack>
-class basis_tuple<CoeffT, _max_degree, _dim, _index, -1,
-                  poly_pack...> {
+          int... _indices>
+class basis_tuple<
+    CoeffT, _max_degree, _dim,
+    std::integer_sequence<int, _indices...> > {
  public:
-  using poly_type = void;
-  using next = void;
-  using tuple_type = std::tuple<poly_pack...>;
-  using tuple_ptr_type = std::tuple<poly_pack...>;
+  using tuple_type = std::tuple<Polynomial<
+      CoeffT, basis_degree(_indices, _dim), _dim>...>;
 };
 
 // Maps an integer index to the exponents
@@ -101,56 +104,124 @@ void index_to_exponents(const int deg_idx, const int degree,
   } else {
     exponents[coeff] = degree;
     for(int c_idx = coeff + 1; c_idx < dim; c_idx++) {
-      exponents[c_idx] = 0.0;
+      exponents[c_idx] = 0;
     }
   }
 }
 
-template <typename CoeffT, int _max_degree, int _dim,
-          int _cur_degree = 0, int _index = 1>
+// Returns the exponents of every term of a polynomial of
+// the specified degree, in the order the polynomial stores
+// their coefficients; ie. for dimension 2
+// (0, 0), (0, 1), (1, 0), (0, 2), (1, 1), (2, 0), ...
+template <int dim>
+std::vector<Array<int, dim> > term_exponents(int degree) {
+  std::vector<Array<int, dim> > terms;
+  terms.reserve(poly_num_coeffs(degree, dim));
+  Array<int, dim> exponents;
+  for(int term_degree = 0; term_degree <= degree;
+      term_degree++) {
+    std::function<void(int, int)> enumerate =
+        [&](int cur_dim, int exp_left) {
+          if(cur_dim == dim - 1) {
+            exponents[cur_dim] = exp_left;
+            terms.push_back(exponents);
+            return;
+          }
+          for(exponents[cur_dim] = 0;
+              exponents[cur_dim] <= exp_left;
+              exponents[cur_dim]++) {
+            enumerate(cur_dim + 1,
+                      exp_left - exponents[cur_dim]);
+          }
+        };
+    enumerate(0, term_degree);
+  }
+  return terms;
+}
+
+// term_exponents for a fixed degree, built on the first
+// call and cached, for kernels which look the exponents up
+// on every call
+template <int degree, int dim>
+const std::vector<Array<int, dim> > &term_exponent_table() {
+  static const std::vector<Array<int, dim> > terms =
+      term_exponents<dim>(degree);
+  return terms;
+}
+
+// Returns the index of the term with the specified
+// exponents in the order term_exponents lists them; this
+// doesn't depend on the polynomial's degree, so
+// coefficients keep their index when the degree changes
+template <int dim>
+int term_index(const Array<int, dim> &exponents) {
+  int exp_left = CTMath::sum(exponents);
+  int idx = exp_left > 0
+                ? poly_num_coeffs<int>(exp_left - 1, dim)
+                : 0;
+  for(int i = 0; i < dim - 1; ++i) {
+    const int nck = dim - i + exp_left - 1;
+    const int term_1 =
+        nck * CTMath::n_choose_k(nck - 1, exp_left);
+    exp_left -= exponents[i];
+    const int term_2 =
+        (nck - exponents[i]) *
+        CTMath::n_choose_k(nck - exponents[i] - 1,
+                           exp_left);
+    idx += (term_1 - term_2) / (dim - i - 1);
+  }
+  return idx;
+}
+
+// Sets each element of the basis tuple to the monomial with
+// the exponents index_to_exponents assigns it
+template <typename CoeffT, int _max_degree, int _dim>
 class BasisGenerators {
  public:
-  static void unit_basis(
+  using tuple_type =
       typename basis_tuple<CoeffT, _max_degree,
-                           _dim>::tuple_type &basis,
-      Array<int, _dim> &exponents) {
-    Polynomial<CoeffT, _cur_degree, _dim> &current =
-        std::get<_index - 1>(basis);
+                           _dim>::tuple_type;
+
+  static void unit_basis(tuple_type &basis,
+                         Array<int, _dim> &exponents) {
+    constexpr const int num_functions =
+        std::tuple_size<tuple_type>::value;
+    unit_basis(
+        basis, exponents,
+        std::make_integer_sequence<int, num_functions>());
+  }
 
-    current = Polynomial<CoeffT, _cur_degree, _dim>(
-        Tags::Zero_Tag());
-    int deg_index =
-        _cur_degree > 0
-            ? std::max(0, _index -
-                              poly_num_coeffs(
-                                  _cur_degree - 1, _dim) -
-                              1)
+ private:
+  template <int... _indices>
+  static void unit_basis(
+      tuple_type &basis, Array<int, _dim> &exponents,
+      std::integer_sequence<int, _indices...>) {
+    using expander = int[];
+    (void)expander{
+        0,
+        (unit_function<_indices>(basis, exponents), 0)...};
+  }
+
+  template <int _index>
+  static void unit_function(tuple_type &basis,
+                            Array<int, _dim> &exponents) {
+    constexpr const int cur_degree =
+        basis_degree(_index, _dim);
+    Polynomial<CoeffT, cur_degree, _dim> &current =
+        std::get<_index>(basis);
 
+    current = Polynomial<CoeffT, cur_degree, _dim>(
+        Tags::Zero_Tag());
+    const int deg_index =
+        cur_degree > 0
+            ? _index - poly_num_coeffs(cur_degree - 1, _dim)
             : 0;
-    index_to_exponents(deg_index, _cur_degree, 0,
+    index_to_exponents(deg_index, cur_degree, 0,
                        exponents);
-    current.coeff(exponents) = 1.0;
-
-    BasisGenerators<CoeffT, _max_degree, _dim,
-                    _index >= poly_num_coeffs(_cur_degree,
-                                              _dim)
-                        ? _cur_degree + 1
-                        : _cur_degree,
-                    _index + 1>::unit_basis(basis,
-                                            exponents);
+    current.coeff(exponents) =
+        CoeffTraits<CoeffT>::one();
   }
 };
-
-template <typename CoeffT, int _max_degree, int _dim,
-          int _index>
-class BasisGenerators<CoeffT, _max_degree, _dim,
-                      _max_degree, _index> {
- public:
-  static void unit_basis(
-      typename basis_tuple<CoeffT, _max_degree,
-                           _dim>::tuple_type &basis,
-      Array<int, _dim> &exponents) {}
-};
 }  // namespace Utilities
 }  // namespace Numerical
 
@@ -0,0 +1,145 @@
+#ifndef _QUADRATURE_HPP_
+#define _QUADRATURE_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+/* A quadrature rule on the reference element: the integral
+ * of f is approximately the sum of weight(i) f(point(i))
+ */
+template <typename CoeffT, int _dim>
+class Quadrature {
+ public:
+  using Point = Array<CoeffT, _dim>;
+  static constexpr const int dim = _dim;
+
+  Quadrature(std::vector<Point> points,
+             std::vector<CoeffT> weights)
+      : pts(std::move(points)), wts(std::move(weights)) {
+    assert(pts.size() == wts.size());
+  }
+
+  /* The tensor product Gauss-Legendre rule with
+   * points_per_axis points on each axis of the reference
+   * cube [0, 1]^_dim; it's exact for polynomials of up to
+   * degree 2 points_per_axis - 1 in each variable.
+   * The points are ordered with the last axis varying
+   * fastest */
+  static Quadrature gauss_legendre(int points_per_axis) {
+    assert(points_per_axis > 0);
+    std::vector<CoeffT> nodes, node_weights;
+    legendre_roots(points_per_axis, nodes, node_weights);
+    int size = 1;
+    for(int d = 0; d < _dim; d++) {
+      size *= points_per_axis;
+    }
+    std::vector<Point> points(size);
+    std::vector<CoeffT> weights(size);
+    for(int i = 0; i < size; i++) {
+      CoeffT w = CoeffTraits<CoeffT>::one();
+      for(int d = _dim - 1, rem = i; d >= 0;
+          d--, rem /= points_per_axis) {
+        const int node = rem % points_per_axis;
+        points[i][d] = nodes[node];
+        w = w * node_weights[node];
+      }
+      weights[i] = w;
+    }
+    return Quadrature(std::move(points),
+                      std::move(weights));
+  }
+
+  int size() const noexcept { return int(pts.size()); }
+
+  const Point &point(int i) const noexcept {
+    assert(i >= 0);
+    assert(i < size());
+    return pts[i];
+  }
+
+  const CoeffT &weight(int i) const noexcept {
+    assert(i >= 0);
+    assert(i < size());
+    return wts[i];
+  }
+
+  const std::vector<Point> &points() const noexcept {
+    return pts;
+  }
+
+  const std::vector<CoeffT> &weights() const noexcept {
+    return wts;
+  }
+
+ private:
+  /* The roots of the Legendre polynomial P_n mapped to
+   * [0, 1], and their weights, found with Newton's method
+   * from the usual asymptotic estimates */
+  static void legendre_roots(int n,
+                             std::vector<CoeffT> &nodes,
+                             std::vector<CoeffT> &weights) {
+    using std::abs;
+    using std::cos;
+    const CoeffT one = CoeffTraits<CoeffT>::one();
+    const CoeffT pi = std::acos(-one);
+    const CoeffT half =
+        one / CoeffTraits<CoeffT>::broadcast(2);
+    nodes.resize(n);
+    weights.resize(n);
+    for(int i = 0; i < (n + 1) / 2; i++) {
+      const CoeffT three_quarters =
+          CoeffTraits<CoeffT>::broadcast(3) * half * half;
+      CoeffT x =
+          cos(pi *
+              (CoeffTraits<CoeffT>::broadcast(i) +
+               three_quarters) /
+              (CoeffTraits<CoeffT>::broadcast(n) + half));
+      CoeffT deriv = one;
+      for(int iter = 0; iter < 100; iter++) {
+        /* P_n(x) by the three term recurrence */
+        CoeffT p_prev = one, p = x;
+        for(int k = 2; k <= n; k++) {
+          const CoeffT p_next =
+              (CoeffTraits<CoeffT>::broadcast(2 * k - 1) *
+                   x * p -
+               CoeffTraits<CoeffT>::broadcast(k - 1) *
+                   p_prev) /
+              CoeffTraits<CoeffT>::broadcast(k);
+          p_prev = p;
+          p = p_next;
+        }
+        deriv = CoeffTraits<CoeffT>::broadcast(n) *
+                (x * p - p_prev) / (x * x - one);
+        const CoeffT step = p / deriv;
+        x = x - step;
+        const CoeffT eps =
+            std::numeric_limits<CoeffT>::epsilon();
+        if(abs(step) <= eps * abs(x)) {
+          break;
+        }
+      }
+      /* The weight on [-1, 1] is 2 / ((1 - x^2) P_n'(x)^2);
+       * mapping to [0, 1] halves it */
+      const CoeffT w =
+          one / ((one - x * x) * deriv * deriv);
+      nodes[i] = half - half * x;
+      nodes[n - 1 - i] = half + half * x;
+      weights[i] = w;
+      weights[n - 1 - i] = w;
+    }
+  }
+
+  std::vector<Point> pts;
+  std::vector<CoeffT> wts;
+};
+}  // namespace Numerical
+
+#endif  // _QUADRATURE_HPP_
@@ -0,0 +1,196 @@
+#ifndef _SIMD_HPP_
+#define _SIMD_HPP_
+
+#include <field.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+
+namespace Numerical {
+
+/* A fixed width vector of scalars with elementwise
+ * arithmetic, built on the GCC vector extensions.
+ * Used as a Polynomial coefficient, lane i of every
+ * coefficient forms an independent polynomial, so one walk
+ * over the coefficients evaluates width polynomials.
+ * Scalars convert implicitly by broadcasting to every lane.
+ */
+template <typename T, int width>
+class simd {
+  static_assert(std::is_arithmetic<T>::value,
+                "simd lanes must be arithmetic types");
+  static_assert(width > 0 && (width & (width - 1)) == 0,
+                "simd width must be a power of two");
+
+ public:
+  /* Only aligned to the scalar, so that containers which
+   * don't over-align their storage are safe; the compiler
+   * emits unaligned vector loads and stores */
+  typedef T vector_t
+      __attribute__((vector_size(sizeof(T) * width),
+                     aligned(alignof(T))));
+
+  static constexpr int size() noexcept { return width; }
+
+  simd() noexcept {}
+
+  template <typename ScalarT,
+            typename std::enable_if<
+                std::is_arithmetic<ScalarT>::value,
+                int>::type = 0>
+  simd(ScalarT s) noexcept {
+    lanes = vector_t{} + T(s);
+  }
+
+  simd(const vector_t &v) noexcept : lanes(v) {}
+
+  /* Reads width scalars from src */
+  static simd load(const T *src) noexcept {
+    simd v;
+    for(int i = 0; i < width; i++) {
+      v.lanes[i] = src[i];
+    }
+    return v;
+  }
+
+  void store(T *dest) const noexcept {
+    for(int i = 0; i < width; i++) {
+      dest[i] = lanes[i];
+    }
+  }
+
+  T operator[](int lane) const noexcept {
+    assert(lane >= 0);
+    assert(lane < width);
+    return lanes[lane];
+  }
+
+  void set(int lane, T value) noexcept {
+    assert(lane >= 0);
+    assert(lane < width);
+    lanes[lane] = value;
+  }
+
+  const vector_t &vector() const noexcept { return lanes; }
+
+  simd operator-() const noexcept { return simd(-lanes); }
+
+  friend simd operator+(const simd &a,
+                        const simd &b) noexcept {
+    return simd(a.lanes + b.lanes);
+  }
+
+  friend simd operator-(const simd &a,
+                        const simd &b) noexcept {
+    return simd(a.lanes - b.lanes);
+  }
+
+  friend simd operator*(const simd &a,
+                        const simd &b) noexcept {
+    return simd(a.lanes * b.lanes);
+  }
+
+  friend simd operator/(const simd &a,
+                        const simd &b) noexcept {
+    return simd(a.lanes / b.lanes);
+  }
+
+  simd &operator+=(const simd &v) noexcept {
+    lanes += v.lanes;
+    return *this;
+  }
+
+  simd &operator-=(const simd &v) noexcept {
+    lanes -= v.lanes;
+    return *this;
+  }
+
+  simd &operator*=(const simd &v) noexcept {
+    lanes *= v.lanes;
+    return *this;
+  }
+
+  simd &operator/=(const simd &v) noexcept {
+    lanes /= v.lanes;
+    return *this;
+  }
+
+  /* True only if every lane is equal */
+  friend bool operator==(const simd &a,
+                         const simd &b) noexcept {
+    for(int i = 0; i < width; i++) {
+      if(a.lanes[i] != b.lanes[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend bool operator!=(const simd &a,
+                         const simd &b) noexcept {
+    return !(a == b);
+  }
+
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const simd &v) {
+    os << "< ";
+    for(int i = 0; i < width; i++) {
+      os << v.lanes[i] << " ";
+    }
+    os << ">";
+    return os;
+  }
+
+ private:
+  vector_t lanes;
+};
+
+template <typename T, int width>
+struct CoeffTraits<simd<T, width> > {
+  using CoeffT = simd<T, width>;
+
+  static CoeffT zero() noexcept { return CoeffT(T(0)); }
+
+  static CoeffT one() noexcept { return CoeffT(T(1)); }
+
+  /* Fused in every lane, with one rounding like std::fma;
+   * with FMA hardware (eg. -mfma) GCC emits vector fused
+   * multiply-adds, otherwise it calls fma per lane */
+  static CoeffT fma(const CoeffT &a, const CoeffT &b,
+                    const CoeffT &c) noexcept {
+    return fused(a, b, c, std::is_floating_point<T>());
+  }
+
+  template <typename ScalarT>
+  static CoeffT broadcast(const ScalarT &s) noexcept {
+    return CoeffT(T(s));
+  }
+
+  static bool is_zero(const CoeffT &c) noexcept {
+    return c == zero();
+  }
+
+ private:
+  static CoeffT fused(const CoeffT &a, const CoeffT &b,
+                      const CoeffT &c,
+                      std::true_type) noexcept {
+    typename CoeffT::vector_t r;
+    for(int i = 0; i < width; i++) {
+      r[i] = std::fma(a.vector()[i], b.vector()[i],
+                      c.vector()[i]);
+    }
+    return CoeffT(r);
+  }
+
+  /* Integer multiply-adds are exact */
+  static CoeffT fused(const CoeffT &a, const CoeffT &b,
+                      const CoeffT &c,
+                      std::false_type) noexcept {
+    return CoeffT(a.vector() * b.vector() + c.vector());
+  }
+};
+}  // namespace Numerical
+
+#endif  // _SIMD_HPP_
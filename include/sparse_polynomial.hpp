@@ -0,0 +1,443 @@
+#ifndef _SPARSE_POLYNOMIAL_HPP_
+#define _SPARSE_POLYNOMIAL_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+#include <tags.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+
+/* A polynomial which only stores its nonzero terms.
+ * Every term is a (key, coefficient) pair, where the key
+ * packs the term's degree and exponents into bit fields of
+ * a 64 bit integer, degree first; the terms are kept
+ * sorted by key, which sorts them by degree like
+ * Polynomial does.
+ * Since the fields don't carry into each other, the key
+ * of the product of two monomials is the sum of their
+ * keys, and multiplying every term by the same monomial
+ * keeps them sorted.
+ */
+template <typename CoeffT, int _dim>
+class SparsePolynomial {
+ public:
+  static constexpr const int dim = _dim;
+  using Key = std::uint64_t;
+
+  static_assert(_dim > 0,
+                "A sparse polynomial needs at least one "
+                "variable");
+  static_assert(_dim < 64,
+                "A sparse polynomial can't have more than "
+                "63 variables");
+
+  /* The number of bits of each field of the key */
+  static constexpr int exponent_bits() noexcept {
+    return 64 / (_dim + 1);
+  }
+
+  /* The largest degree a term may have */
+  static constexpr int max_degree() noexcept {
+    return exponent_bits() >= 31
+               ? 0x7fffffff
+               : (1 << exponent_bits()) - 1;
+  }
+
+  struct Term {
+    Key key;
+    CoeffT coeff;
+  };
+
+  SparsePolynomial() {}
+
+  template <int _degree>
+  explicit SparsePolynomial(
+      const Polynomial<CoeffT, _degree, _dim> &p) {
+    static_assert(_degree <= max_degree(),
+                  "The polynomial's degree is too large "
+                  "for the key");
+    const std::vector<Array<int, _dim> > exponents =
+        Utilities::term_exponents<_dim>(_degree);
+    for(int i = 0; i < int(exponents.size()); i++) {
+      const CoeffT &c = p.data()[i];
+      if(!CoeffTraits<CoeffT>::is_zero(c)) {
+        terms.push_back(Term{pack(exponents[i]), c});
+      }
+    }
+    std::sort(terms.begin(), terms.end(),
+              [](const Term &a, const Term &b) {
+                return a.key < b.key;
+              });
+  }
+
+  /* Converts to a dense polynomial, which must be of a
+   * large enough degree to hold every term */
+  template <int _degree>
+  Polynomial<CoeffT, _degree, _dim> to_dense() const
+      noexcept {
+    assert(degree() <= _degree);
+    Polynomial<CoeffT, _degree, _dim> p((Tags::Zero_Tag()));
+    for(const Term &t : terms) {
+      p.coeff(unpack(t.key)) = t.coeff;
+    }
+    return p;
+  }
+
+  static Key pack(
+      const Array<int, _dim> &exponents) noexcept {
+    Key key = 0;
+    Key degree = 0;
+    for(int i = 0; i < _dim; i++) {
+      assert(exponents[i] >= 0);
+      degree += exponents[i];
+      key |= Key(exponents[i]) << field_shift(i);
+    }
+    assert(degree <= Key(max_degree()));
+    return key | (degree << field_shift(-1));
+  }
+
+  static Array<int, _dim> unpack(Key key) noexcept {
+    Array<int, _dim> exponents;
+    for(int i = 0; i < _dim; i++) {
+      exponents[i] = int((key >> field_shift(i)) & mask());
+    }
+    return exponents;
+  }
+
+  static int key_degree(Key key) noexcept {
+    return int((key >> field_shift(-1)) & mask());
+  }
+
+  /* The degree of the highest degree nonzero term, or 0 if
+   * there aren't any */
+  int degree() const noexcept {
+    return terms.empty() ? 0 : key_degree(terms.back().key);
+  }
+
+  int num_terms() const noexcept {
+    return int(terms.size());
+  }
+
+  const Term *begin() const noexcept {
+    return terms.data();
+  }
+
+  const Term *end() const noexcept {
+    return terms.data() + terms.size();
+  }
+
+  template <typename... int_list,
+            typename std::enable_if<
+                sizeof...(int_list) == _dim, int>::type = 0>
+  CoeffT coeff(int_list... args) const noexcept {
+    return coeff(Array<int, _dim>(args...));
+  }
+
+  CoeffT coeff(const Array<int, _dim> &exponents) const
+      noexcept {
+    const auto t = find(pack(exponents));
+    if(t != terms.end() && t->key == pack(exponents)) {
+      return t->coeff;
+    }
+    return CoeffTraits<CoeffT>::zero();
+  }
+
+  /* Adds c times the monomial to the polynomial */
+  void add_term(const Array<int, _dim> &exponents,
+                const CoeffT &c) {
+    const Key key = pack(exponents);
+    const auto t = find(key);
+    if(t != terms.end() && t->key == key) {
+      t->coeff += c;
+      if(CoeffTraits<CoeffT>::is_zero(t->coeff)) {
+        terms.erase(t);
+      }
+    } else if(!CoeffTraits<CoeffT>::is_zero(c)) {
+      terms.insert(t, Term{key, c});
+    }
+  }
+
+  SparsePolynomial operator+(
+      const SparsePolynomial &rhs) const {
+    return merge(rhs, CoeffTraits<CoeffT>::one());
+  }
+
+  SparsePolynomial operator-(
+      const SparsePolynomial &rhs) const {
+    return merge(rhs, -CoeffTraits<CoeffT>::one());
+  }
+
+  SparsePolynomial operator-() const {
+    SparsePolynomial n(*this);
+    for(Term &t : n.terms) {
+      t.coeff = -t.coeff;
+    }
+    return n;
+  }
+
+  SparsePolynomial operator+(const CoeffT &scalar) const {
+    SparsePolynomial s(*this);
+    s.add_term(Array<int, _dim>(Tags::Zero_Tag()), scalar);
+    return s;
+  }
+
+  SparsePolynomial operator-(const CoeffT &scalar) const {
+    return *this + -scalar;
+  }
+
+  SparsePolynomial operator*(const CoeffT &scalar) const {
+    SparsePolynomial s;
+    if(CoeffTraits<CoeffT>::is_zero(scalar)) {
+      return s;
+    }
+    s.terms.reserve(terms.size());
+    for(const Term &t : terms) {
+      const CoeffT c = t.coeff * scalar;
+      if(!CoeffTraits<CoeffT>::is_zero(c)) {
+        s.terms.push_back(Term{t.key, c});
+      }
+    }
+    return s;
+  }
+
+  /* Multiplies the polynomials with a heap of the next
+   * product from every term of the shorter polynomial, so
+   * the products come out in order and are accumulated as
+   * they're generated, without sorting or hashing */
+  SparsePolynomial product(
+      const SparsePolynomial &m) const {
+    SparsePolynomial prod;
+    if(terms.empty() || m.terms.empty()) {
+      return prod;
+    }
+    assert(degree() + m.degree() <= max_degree());
+    const std::vector<Term> &a =
+        terms.size() <= m.terms.size() ? terms : m.terms;
+    const std::vector<Term> &b =
+        terms.size() <= m.terms.size() ? m.terms : terms;
+    /* Entries are the product key, the index into a, and
+     * the index into b */
+    using Entry = std::pair<Key, std::pair<int, int> >;
+    std::priority_queue<Entry, std::vector<Entry>,
+                        std::greater<Entry> >
+        heap;
+    for(int i = 0; i < int(a.size()); i++) {
+      heap.push(Entry(a[i].key + b[0].key,
+                      std::make_pair(i, 0)));
+    }
+    while(!heap.empty()) {
+      const Key key = heap.top().first;
+      CoeffT sum = CoeffTraits<CoeffT>::zero();
+      while(!heap.empty() && heap.top().first == key) {
+        const int i = heap.top().second.first;
+        const int j = heap.top().second.second;
+        heap.pop();
+        sum = CoeffTraits<CoeffT>::fma(a[i].coeff,
+                                       b[j].coeff, sum);
+        if(j + 1 < int(b.size())) {
+          heap.push(Entry(a[i].key + b[j + 1].key,
+                          std::make_pair(i, j + 1)));
+        }
+      }
+      if(!CoeffTraits<CoeffT>::is_zero(sum)) {
+        prod.terms.push_back(Term{key, sum});
+      }
+    }
+    return prod;
+  }
+
+  SparsePolynomial operator*(
+      const SparsePolynomial &m) const {
+    return product(m);
+  }
+
+  SparsePolynomial integrate(
+      int variable,
+      CoeffT constant = CoeffTraits<CoeffT>::zero()) const {
+    assert(variable >= 0);
+    assert(variable < _dim);
+    assert(degree() < max_degree());
+    const Key offset = unit_key(variable);
+    SparsePolynomial integral;
+    integral.terms.reserve(terms.size() + 1);
+    if(!CoeffTraits<CoeffT>::is_zero(constant)) {
+      integral.terms.push_back(Term{0, constant});
+    }
+    for(const Term &t : terms) {
+      const Key key = t.key + offset;
+      const CoeffT factor =
+          CoeffTraits<CoeffT>::one() /
+          CoeffTraits<CoeffT>::broadcast(
+              exponent(key, variable));
+      integral.terms.push_back(Term{key, factor * t.coeff});
+    }
+    return integral;
+  }
+
+  SparsePolynomial differentiate(int variable) const {
+    assert(variable >= 0);
+    assert(variable < _dim);
+    const Key offset = unit_key(variable);
+    SparsePolynomial derivative;
+    for(const Term &t : terms) {
+      const int e = exponent(t.key, variable);
+      if(e > 0) {
+        const CoeffT factor =
+            CoeffTraits<CoeffT>::broadcast(e);
+        derivative.terms.push_back(
+            Term{t.key - offset, factor * t.coeff});
+      }
+    }
+    return derivative;
+  }
+
+  template <typename... subs_list,
+            typename std::enable_if<
+                sizeof...(subs_list) == _dim,
+                int>::type = 0>
+  CoeffT eval(subs_list... vars) const {
+    return eval(Array<CoeffT, _dim>(vars...));
+  }
+
+  /* The powers of each variable up to the degree are
+   * computed once, then each term is a product of _dim of
+   * them */
+  CoeffT eval(const Array<CoeffT, _dim> &vars) const {
+    const int deg = degree();
+    std::vector<CoeffT> powers(_dim * (deg + 1));
+    for(int i = 0; i < _dim; i++) {
+      CoeffT *p = &powers[i * (deg + 1)];
+      p[0] = CoeffTraits<CoeffT>::one();
+      for(int e = 1; e <= deg; e++) {
+        p[e] = p[e - 1] * vars[i];
+      }
+    }
+    CoeffT sum = CoeffTraits<CoeffT>::zero();
+    for(const Term &t : terms) {
+      CoeffT m = t.coeff;
+      for(int i = 0; i < _dim; i++) {
+        const int e = exponent(t.key, i);
+        if(e > 0) {
+          m = m * powers[i * (deg + 1) + e];
+        }
+      }
+      sum = sum + m;
+    }
+    return sum;
+  }
+
+  bool operator==(const SparsePolynomial &rhs) const {
+    if(terms.size() != rhs.terms.size()) {
+      return false;
+    }
+    for(int i = 0; i < int(terms.size()); i++) {
+      if(terms[i].key != rhs.terms[i].key ||
+         !(terms[i].coeff == rhs.terms[i].coeff)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool operator!=(const SparsePolynomial &rhs) const {
+    return !(*this == rhs);
+  }
+
+ private:
+  /* The degree's field is the most significant, followed
+   * by the exponents of variables 0 through _dim - 1 */
+  static constexpr int field_shift(int variable) noexcept {
+    return (_dim - 1 - variable) * exponent_bits();
+  }
+
+  static constexpr Key mask() noexcept {
+    return (Key(1) << exponent_bits()) - 1;
+  }
+
+  static int exponent(Key key, int variable) noexcept {
+    return int((key >> field_shift(variable)) & mask());
+  }
+
+  /* The key of the monomial of degree 1 in variable */
+  static Key unit_key(int variable) noexcept {
+    return (Key(1) << field_shift(variable)) |
+           (Key(1) << field_shift(-1));
+  }
+
+  typename std::vector<Term>::iterator find(Key key) {
+    return std::lower_bound(
+        terms.begin(), terms.end(), key,
+        [](const Term &t, Key k) { return t.key < k; });
+  }
+
+  typename std::vector<Term>::const_iterator find(
+      Key key) const {
+    return std::lower_bound(
+        terms.begin(), terms.end(), key,
+        [](const Term &t, Key k) { return t.key < k; });
+  }
+
+  /* Returns this + sign * rhs, merging the sorted terms */
+  SparsePolynomial merge(const SparsePolynomial &rhs,
+                         const CoeffT &sign) const {
+    SparsePolynomial s;
+    s.terms.reserve(terms.size() + rhs.terms.size());
+    auto l = terms.begin();
+    auto r = rhs.terms.begin();
+    while(l != terms.end() || r != rhs.terms.end()) {
+      if(r == rhs.terms.end() ||
+         (l != terms.end() && l->key < r->key)) {
+        s.terms.push_back(*l);
+        ++l;
+      } else if(l == terms.end() || r->key < l->key) {
+        s.terms.push_back(Term{r->key, sign * r->coeff});
+        ++r;
+      } else {
+        const CoeffT c = l->coeff + sign * r->coeff;
+        if(!CoeffTraits<CoeffT>::is_zero(c)) {
+          s.terms.push_back(Term{l->key, c});
+        }
+        ++l;
+        ++r;
+      }
+    }
+    return s;
+  }
+
+  std::vector<Term> terms;
+};
+
+template <typename CoeffT, int _dim>
+SparsePolynomial<CoeffT, _dim> operator+(
+    const CoeffT &scalar,
+    const SparsePolynomial<CoeffT, _dim> &p) {
+  return p + scalar;
+}
+
+template <typename CoeffT, int _dim>
+SparsePolynomial<CoeffT, _dim> operator-(
+    const CoeffT &scalar,
+    const SparsePolynomial<CoeffT, _dim> &p) {
+  return -p + scalar;
+}
+
+template <typename CoeffT, int _dim>
+SparsePolynomial<CoeffT, _dim> operator*(
+    const CoeffT &scalar,
+    const SparsePolynomial<CoeffT, _dim> &p) {
+  return p * scalar;
+}
+}  // namespace Numerical
+
+#endif  // _SPARSE_POLYNOMIAL_HPP_
@@ -0,0 +1,241 @@
+#ifndef _TIME_INTEGRATION_HPP_
+#define _TIME_INTEGRATION_HPP_
+
+#include <parallel.hpp>
+
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Numerical {
+namespace TimeIntegration {
+
+/* Accumulates the wall time spent in RK stages and the
+ * number of element updates they performed */
+class StageTimer {
+ public:
+  StageTimer() { reset(); }
+
+  void reset() noexcept {
+    elapsed = std::chrono::duration<double>::zero();
+    updates = 0;
+    stages = 0;
+  }
+
+  void start() noexcept { started = Clock::now(); }
+
+  void stop(long element_updates) noexcept {
+    elapsed += Clock::now() - started;
+    updates += element_updates;
+    stages++;
+  }
+
+  double seconds() const noexcept {
+    return elapsed.count();
+  }
+
+  long element_updates() const noexcept { return updates; }
+
+  long num_stages() const noexcept { return stages; }
+
+  /* Element updates per second */
+  double throughput() const noexcept {
+    return seconds() > 0.0 ? updates / seconds() : 0.0;
+  }
+
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const StageTimer &t) {
+    os << t.num_stages() << " stages, "
+       << t.element_updates() << " element updates in "
+       << t.seconds() << " s (" << t.throughput()
+       << " element updates/s)";
+    return os;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point started;
+  std::chrono::duration<double> elapsed;
+  long updates;
+  long stages;
+};
+
+enum class Scheme {
+  /* Shu and Osher's three stage, third order strong
+   * stability preserving scheme */
+  SSP_RK3,
+  /* Carpenter and Kennedy's five stage, fourth order 2N
+   * storage scheme */
+  LSRK54,
+};
+
+/* Explicit Runge-Kutta integrator for block vectors of
+ * per-element coefficients, ie. std::vector<Polynomial>.
+ * Besides the solution only two blocks are kept: the
+ * right-hand side and one register of the low storage
+ * recurrence. Each stage evaluates the right-hand side and
+ * then updates both registers in one pass over memory.
+ */
+template <typename ElemT>
+class ExplicitRK {
+ public:
+  using CoeffT = typename std::remove_const<
+      typename std::remove_reference<decltype(
+          *std::declval<ElemT &>().data())>::type>::type;
+  using Block = std::vector<ElemT>;
+  /* rhs(t, U, R) must overwrite every element of R with
+   * the time derivative of U */
+  using RHS =
+      std::function<void(double, const Block &, Block &)>;
+
+  ExplicitRK(Scheme scheme, RHS rhs,
+             Parallel::Scheduler *sched = nullptr)
+      : scheme(scheme), rhs(std::move(rhs)), sched(sched) {}
+
+  /* Advances U from t to t + dt */
+  void step(Block &U, double t, double dt) {
+    R.resize(U.size());
+    S.resize(U.size());
+    switch(scheme) {
+      case Scheme::SSP_RK3:
+        step_ssp_rk3(U, t, dt);
+        break;
+      case Scheme::LSRK54:
+        step_lsrk54(U, t, dt);
+        break;
+    }
+  }
+
+  int num_stages() const noexcept {
+    return scheme == Scheme::SSP_RK3 ? 3 : 5;
+  }
+
+  const StageTimer &timer() const noexcept { return clock; }
+
+  StageTimer &timer() noexcept { return clock; }
+
+ private:
+  void step_ssp_rk3(Block &U, double t, double dt) {
+    /* S holds the solution at the start of the step; the
+     * stage solutions are
+     * U = alpha S + (1 - alpha) (U + dt R(U)) */
+    constexpr const double alpha[3] = {0.0, 3.0 / 4.0,
+                                       1.0 / 3.0};
+    constexpr const double c[3] = {0.0, 1.0, 1.0 / 2.0};
+    for(int s = 0; s < 3; s++) {
+      clock.start();
+      rhs(t + c[s] * dt, U, R);
+      const CoeffT a(alpha[s]);
+      const CoeffT b(1.0 - alpha[s]);
+      const CoeffT h(dt);
+      const bool first = (s == 0);
+      for_coeffs(U, [&](CoeffT *u, CoeffT *saved,
+                        const CoeffT *r, int n) {
+        for(int i = 0; i < n; i++) {
+          if(first) {
+            saved[i] = u[i];
+          }
+          u[i] = a * saved[i] + b * (u[i] + h * r[i]);
+        }
+      });
+      clock.stop(long(U.size()));
+    }
+  }
+
+  void step_lsrk54(Block &U, double t, double dt) {
+    /* S holds the 2N register; each stage computes
+     * S = A S + dt R(U)
+     * U = U + B S */
+    constexpr const double A[5] = {
+        0.0, -567301805773.0 / 1357537059087.0,
+        -2404267990393.0 / 2016746695238.0,
+        -3550918686646.0 / 2091501179385.0,
+        -1275806237668.0 / 842570457699.0};
+    constexpr const double B[5] = {
+        1432997174477.0 / 9575080441755.0,
+        5161836677717.0 / 13612068292357.0,
+        1720146321549.0 / 2090206949498.0,
+        3134564353537.0 / 4481467310338.0,
+        2277821191437.0 / 14882151754819.0};
+    constexpr const double c[5] = {
+        0.0, 1432997174477.0 / 9575080441755.0,
+        2526269341429.0 / 6820363962896.0,
+        2006345519317.0 / 3224310063776.0,
+        2802321613138.0 / 2924317926251.0};
+    for(int s = 0; s < 5; s++) {
+      clock.start();
+      rhs(t + c[s] * dt, U, R);
+      const CoeffT a(A[s]);
+      const CoeffT b(B[s]);
+      const CoeffT h(dt);
+      const bool first = (s == 0);
+      for_coeffs(U, [&](CoeffT *u, CoeffT *reg,
+                        const CoeffT *r, int n) {
+        for(int i = 0; i < n; i++) {
+          /* A[0] is zero, don't read the stale register */
+          reg[i] = first ? h * r[i] : a * reg[i] + h * r[i];
+          u[i] = u[i] + b * reg[i];
+        }
+      });
+      clock.stop(long(U.size()));
+    }
+  }
+
+  /* Calls update(u, s, r, n) on the coefficients of chunks
+   * of elements */
+  template <typename Update>
+  void for_coeffs(Block &U, Update &&update) {
+    constexpr const int elem_coeffs = ElemT::num_coeffs;
+    auto chunk = [&](int lo, int hi, int) {
+      update(U[lo].data(), S[lo].data(), R[lo].data(),
+             (hi - lo) * elem_coeffs);
+    };
+    if(sched != nullptr) {
+      sched->parallel_for_chunks(0, int(U.size()), chunk);
+    } else {
+      chunk(0, int(U.size()), 0);
+    }
+  }
+
+  static_assert(sizeof(ElemT) ==
+                    ElemT::num_coeffs * sizeof(CoeffT),
+                "The element's coefficients must be stored "
+                "contiguously to be updated as a block");
+
+  Scheme scheme;
+  RHS rhs;
+  Parallel::Scheduler *sched;
+  Block R;
+  Block S;
+  StageTimer clock;
+};
+
+/* Builds a block right-hand side from an element kernel
+ * kernel(t, U, elem, R_elem, thread), which is run over
+ * the elements in parallel when a scheduler is given */
+template <typename ElemT, typename Kernel>
+typename ExplicitRK<ElemT>::RHS element_rhs(
+    Kernel kernel, Parallel::Scheduler *sched = nullptr) {
+  using Block = typename ExplicitRK<ElemT>::Block;
+  return [kernel, sched](double t, const Block &U,
+                         Block &R) {
+    if(sched != nullptr) {
+      sched->parallel_for(
+          0, int(U.size()), [&](int e, int thread) {
+            kernel(t, U, e, R[e], thread);
+          });
+    } else {
+      for(int e = 0; e < int(U.size()); e++) {
+        kernel(t, U, e, R[e], 0);
+      }
+    }
+  };
+}
+}  // namespace TimeIntegration
+}  // namespace Numerical
+
+#endif  // _TIME_INTEGRATION_HPP_
@@ -0,0 +1,378 @@
+#ifndef _VECTOR_POLYNOMIAL_HPP_
+#define _VECTOR_POLYNOMIAL_HPP_
+
+#include <array.hpp>
+#include <field.hpp>
+#include <polynomial.hpp>
+#include <polynomial_utils.hpp>
+#include <tags.hpp>
+
+#include <cassert>
+#include <vector>
+
+namespace Numerical {
+
+namespace Internal {
+
+/* The terms of a polynomial of degree _degree in storage
+ * order with the indices of their first and second
+ * derivatives by each variable; -1 where the derivative
+ * of the term is zero.
+ * Term indices don't depend on the polynomial's degree, so
+ * these index the lower degree derivatives directly */
+template <int _degree, int _dim>
+struct DerivativeTable {
+  std::vector<Array<int, _dim> > exponents;
+  std::vector<Array<int, _dim> > first;
+  std::vector<Array<int, _dim> > second;
+};
+
+/* Built on the first call and cached; building it
+ * allocates, so its callers can throw std::bad_alloc */
+template <int _degree, int _dim>
+const DerivativeTable<_degree, _dim> &derivative_table() {
+  static const DerivativeTable<_degree, _dim> table = [] {
+    DerivativeTable<_degree, _dim> t;
+    t.exponents = Utilities::term_exponents<_dim>(_degree);
+    for(const Array<int, _dim> &e : t.exponents) {
+      Array<int, _dim> first, second;
+      for(int v = 0; v < _dim; v++) {
+        Array<int, _dim> lowered(e);
+        lowered[v] -= 1;
+        first[v] = e[v] >= 1
+                       ? Utilities::term_index(lowered)
+                       : -1;
+        lowered[v] -= 1;
+        second[v] = e[v] >= 2
+                        ? Utilities::term_index(lowered)
+                        : -1;
+      }
+      t.first.push_back(first);
+      t.second.push_back(second);
+    }
+    return t;
+  }();
+  return table;
+}
+}  // namespace Internal
+
+/* A polynomial with _ncomp components, such as a velocity
+ * or displacement field.
+ * The components' coefficients of each term are stored
+ * together, so the differential operators and eval make
+ * one pass over the terms for every component, sharing
+ * one cached DerivativeTable.
+ * Derivatives of constants are constant (zero), as with
+ * the degree 0 Polynomial.
+ */
+template <typename CoeffT, int _degree, int _dim,
+          int _ncomp = _dim>
+class VectorPolynomial {
+ public:
+  using coeff_type = CoeffT;
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  using Value = Array<CoeffT, _ncomp>;
+  using Point = Array<CoeffT, _dim>;
+  /* The Jacobian, with the derivatives of component c in
+   * row c */
+  using Jacobian = Array<Array<CoeffT, _dim>, _ncomp>;
+  static constexpr const int dim = _dim;
+  static constexpr const int degree = _degree;
+  static constexpr const int ncomp = _ncomp;
+  static constexpr const int num_coeffs = Poly::num_coeffs;
+  static constexpr const int deriv_degree =
+      _degree > 0 ? _degree - 1 : 0;
+  static constexpr const int laplacian_degree =
+      _degree > 1 ? _degree - 2 : 0;
+
+  using Gradient =
+      VectorPolynomial<CoeffT, deriv_degree, _dim,
+                       _ncomp * _dim>;
+  using Divergence = Polynomial<CoeffT, deriv_degree, _dim>;
+  /* The 2D curl is the scalar d_0 u_1 - d_1 u_0 */
+  using Curl = VectorPolynomial<CoeffT, deriv_degree, _dim,
+                                _dim == 3 ? 3 : 1>;
+  using Laplacian =
+      VectorPolynomial<CoeffT, laplacian_degree, _dim,
+                       _ncomp>;
+
+  VectorPolynomial() {}
+
+  explicit VectorPolynomial(const Tags::Zero_Tag &) {
+    for(int k = 0; k < num_coeffs; k++) {
+      for(int c = 0; c < _ncomp; c++) {
+        values[k][c] = CoeffTraits<CoeffT>::zero();
+      }
+    }
+  }
+
+  explicit VectorPolynomial(
+      const Array<Poly, _ncomp> &components) {
+    for(int c = 0; c < _ncomp; c++) {
+      set_component(c, components[c]);
+    }
+  }
+
+  /* Coefficient k of every component */
+  Value &coeffs(int k) noexcept {
+    assert(k >= 0);
+    assert(k < num_coeffs);
+    return values[k];
+  }
+
+  const Value &coeffs(int k) const noexcept {
+    assert(k >= 0);
+    assert(k < num_coeffs);
+    return values[k];
+  }
+
+  CoeffT &coeff(int k, int comp) noexcept {
+    return coeffs(k)[comp];
+  }
+
+  const CoeffT &coeff(int k, int comp) const noexcept {
+    return coeffs(k)[comp];
+  }
+
+  Poly component(int comp) const noexcept {
+    assert(comp >= 0);
+    assert(comp < _ncomp);
+    Poly p;
+    for(int k = 0; k < num_coeffs; k++) {
+      p.data()[k] = values[k][comp];
+    }
+    return p;
+  }
+
+  void set_component(int comp, const Poly &p) noexcept {
+    assert(comp >= 0);
+    assert(comp < _ncomp);
+    for(int k = 0; k < num_coeffs; k++) {
+      values[k][comp] = p.data()[k];
+    }
+  }
+
+  VectorPolynomial operator+(
+      const VectorPolynomial &rhs) const noexcept {
+    VectorPolynomial s;
+    for(int k = 0; k < num_coeffs; k++) {
+      for(int c = 0; c < _ncomp; c++) {
+        s.values[k][c] = values[k][c] + rhs.values[k][c];
+      }
+    }
+    return s;
+  }
+
+  VectorPolynomial operator-(
+      const VectorPolynomial &rhs) const noexcept {
+    VectorPolynomial s;
+    for(int k = 0; k < num_coeffs; k++) {
+      for(int c = 0; c < _ncomp; c++) {
+        s.values[k][c] = values[k][c] - rhs.values[k][c];
+      }
+    }
+    return s;
+  }
+
+  VectorPolynomial operator*(const CoeffT &factor) const
+      noexcept {
+    VectorPolynomial s;
+    for(int k = 0; k < num_coeffs; k++) {
+      for(int c = 0; c < _ncomp; c++) {
+        s.values[k][c] = values[k][c] * factor;
+      }
+    }
+    return s;
+  }
+
+  /* Every component evaluated at point; each monomial is
+   * evaluated once for all of them */
+  Value eval(const Point &point) const {
+    const auto &table =
+        Internal::derivative_table<_degree, _dim>();
+    const Powers powers = point_powers(point);
+    Value v;
+    for(int c = 0; c < _ncomp; c++) {
+      v[c] = CoeffTraits<CoeffT>::zero();
+    }
+    for(int k = 0; k < num_coeffs; k++) {
+      CoeffT m = CoeffTraits<CoeffT>::one();
+      for(int d = 0; d < _dim; d++) {
+        m = m * powers[d][table.exponents[k][d]];
+      }
+      for(int c = 0; c < _ncomp; c++) {
+        v[c] = CoeffTraits<CoeffT>::fma(values[k][c], m,
+                                        v[c]);
+      }
+    }
+    return v;
+  }
+
+  /* The Jacobian at point in one pass over the terms,
+   * without building the gradient; eg. the strain rate is
+   * (J + J^T) / 2 */
+  Jacobian eval_gradient(const Point &point) const {
+    const auto &table =
+        Internal::derivative_table<_degree, _dim>();
+    const Powers powers = point_powers(point);
+    Jacobian J;
+    for(int c = 0; c < _ncomp; c++) {
+      for(int v = 0; v < _dim; v++) {
+        J[c][v] = CoeffTraits<CoeffT>::zero();
+      }
+    }
+    for(int k = 0; k < num_coeffs; k++) {
+      const Array<int, _dim> &e = table.exponents[k];
+      for(int v = 0; v < _dim; v++) {
+        if(e[v] == 0) {
+          continue;
+        }
+        CoeffT partial =
+            CoeffTraits<CoeffT>::broadcast(e[v]);
+        for(int d = 0; d < _dim; d++) {
+          partial =
+              partial * powers[d][e[d] - int(d == v)];
+        }
+        for(int c = 0; c < _ncomp; c++) {
+          J[c][v] = CoeffTraits<CoeffT>::fma(
+              values[k][c], partial, J[c][v]);
+        }
+      }
+    }
+    return J;
+  }
+
+  /* Component c * _dim + v of the gradient is
+   * d u_c / d x_v */
+  Gradient grad() const {
+    const auto &table =
+        Internal::derivative_table<_degree, _dim>();
+    Gradient g((Tags::Zero_Tag()));
+    for(int k = 0; k < num_coeffs; k++) {
+      for(int v = 0; v < _dim; v++) {
+        const int target = table.first[k][v];
+        if(target < 0) {
+          continue;
+        }
+        const CoeffT factor =
+            CoeffTraits<CoeffT>::broadcast(
+                table.exponents[k][v]);
+        for(int c = 0; c < _ncomp; c++) {
+          g.coeff(target, c * _dim + v) =
+              values[k][c] * factor;
+        }
+      }
+    }
+    return g;
+  }
+
+  Divergence div() const {
+    static_assert(_ncomp == _dim,
+                  "The divergence needs one component per "
+                  "dimension");
+    const auto &table =
+        Internal::derivative_table<_degree, _dim>();
+    Divergence d((Tags::Zero_Tag()));
+    for(int k = 0; k < num_coeffs; k++) {
+      for(int v = 0; v < _dim; v++) {
+        const int target = table.first[k][v];
+        if(target < 0) {
+          continue;
+        }
+        d.data()[target] = CoeffTraits<CoeffT>::fma(
+            values[k][v],
+            CoeffTraits<CoeffT>::broadcast(
+                table.exponents[k][v]),
+            d.data()[target]);
+      }
+    }
+    return d;
+  }
+
+  /* curl_i = eps_ijk d_j u_k in 3D */
+  Curl curl() const {
+    static_assert(_ncomp == _dim &&
+                      (_dim == 2 || _dim == 3),
+                  "The curl is only defined for 2D and 3D "
+                  "vector fields");
+    const auto &table =
+        Internal::derivative_table<_degree, _dim>();
+    Curl r((Tags::Zero_Tag()));
+    for(int k = 0; k < num_coeffs; k++) {
+      for(int v = 0; v < _dim; v++) {
+        const int target = table.first[k][v];
+        if(target < 0) {
+          continue;
+        }
+        const CoeffT factor =
+            CoeffTraits<CoeffT>::broadcast(
+                table.exponents[k][v]);
+        for(int c = 0; c < _dim; c++) {
+          if(c == v) {
+            continue;
+          }
+          /* In 2D only (v, c) = (0, 1) is positive; in 3D
+           * the cyclic permutations (i, v, c) are */
+          const int i = _dim == 3 ? 3 - v - c : 0;
+          const bool positive =
+              _dim == 3 ? v == (i + 1) % 3 : v == 0;
+          CoeffT &dest = r.coeff(target, i);
+          const CoeffT term = values[k][c] * factor;
+          dest = positive ? dest + term : dest - term;
+        }
+      }
+    }
+    return r;
+  }
+
+  /* The Laplacian of each component */
+  Laplacian laplacian() const {
+    const auto &table =
+        Internal::derivative_table<_degree, _dim>();
+    Laplacian l((Tags::Zero_Tag()));
+    for(int k = 0; k < num_coeffs; k++) {
+      for(int v = 0; v < _dim; v++) {
+        const int target = table.second[k][v];
+        if(target < 0) {
+          continue;
+        }
+        const int e = table.exponents[k][v];
+        const CoeffT factor =
+            CoeffTraits<CoeffT>::broadcast(e * (e - 1));
+        for(int c = 0; c < _ncomp; c++) {
+          l.coeff(target, c) = CoeffTraits<CoeffT>::fma(
+              values[k][c], factor, l.coeff(target, c));
+        }
+      }
+    }
+    return l;
+  }
+
+ private:
+  using Powers = Array<Array<CoeffT, _degree + 1>, _dim>;
+
+  static Powers point_powers(const Point &point) noexcept {
+    Powers powers;
+    for(int d = 0; d < _dim; d++) {
+      powers[d][0] = CoeffTraits<CoeffT>::one();
+      for(int e = 1; e <= _degree; e++) {
+        powers[d][e] = powers[d][e - 1] * point[d];
+      }
+    }
+    return powers;
+  }
+
+  Array<Value, num_coeffs> values;
+};
+
+template <typename CoeffT, int _degree, int _dim,
+          int _ncomp>
+VectorPolynomial<CoeffT, _degree, _dim, _ncomp> operator*(
+    const CoeffT &factor,
+    const VectorPolynomial<CoeffT, _degree, _dim, _ncomp>
+        &p) noexcept {
+  return p * factor;
+}
+}  // namespace Numerical
+
+#endif  // _VECTOR_POLYNOMIAL_HPP_
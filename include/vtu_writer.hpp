@@ -0,0 +1,579 @@
+#ifndef _VTU_WRITER_HPP_
+#define _VTU_WRITER_HPP_
+
+#include <array.hpp>
+#include <polynomial.hpp>
+#include <polynomial_eval.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Numerical {
+namespace IO {
+
+enum class CellShape {
+  /* The reference element [0, 1]^dim */
+  Box,
+  /* The reference element with vertices at the origin and
+   * the unit vectors */
+  Simplex,
+};
+
+enum class VTUCompression {
+  Raw,
+  ZLib,
+};
+
+/* The Lagrange nodes of VTK's high-order cells, in the
+ * order VTK expects them, as integer lattice coordinates;
+ * divide by the order for the reference coordinates
+ */
+template <int dim>
+std::vector<Array<int, dim> > lagrange_nodes(
+    CellShape shape, int order);
+
+namespace Internal {
+
+/* vtkHigherOrderQuadrilateral/Hexahedron node ordering:
+ * vertices, edges, faces, then the body */
+inline int box_node_index(int i, int j, int n) {
+  const bool ibdy = (i == 0 || i == n);
+  const bool jbdy = (j == 0 || j == n);
+  const int nbdy = (ibdy ? 1 : 0) + (jbdy ? 1 : 0);
+  if(nbdy == 2) {
+    return (i ? (j ? 2 : 1) : (j ? 3 : 0));
+  }
+  int offset = 4;
+  if(nbdy == 1) {
+    if(!ibdy) {
+      return (i - 1) + (j ? 2 * (n - 1) : 0) + offset;
+    }
+    return (j - 1) + (i ? n - 1 : 3 * (n - 1)) + offset;
+  }
+  offset += 4 * (n - 1);
+  return offset + (i - 1) + (n - 1) * (j - 1);
+}
+
+inline int box_node_index(int i, int j, int k, int n) {
+  const bool ibdy = (i == 0 || i == n);
+  const bool jbdy = (j == 0 || j == n);
+  const bool kbdy = (k == 0 || k == n);
+  const int nbdy =
+      (ibdy ? 1 : 0) + (jbdy ? 1 : 0) + (kbdy ? 1 : 0);
+  const int m = n - 1;
+  if(nbdy == 3) {
+    return (i ? (j ? 2 : 1) : (j ? 3 : 0)) + (k ? 4 : 0);
+  }
+  int offset = 8;
+  if(nbdy == 2) {
+    if(!ibdy) {
+      return (i - 1) + (j ? 2 * m : 0) + (k ? 4 * m : 0) +
+             offset;
+    }
+    if(!jbdy) {
+      return (j - 1) + (i ? m : 3 * m) + (k ? 4 * m : 0) +
+             offset;
+    }
+    offset += 8 * m;
+    return (k - 1) + m * (i ? (j ? 3 : 1) : (j ? 2 : 0)) +
+           offset;
+  }
+  offset += 12 * m;
+  if(nbdy == 1) {
+    if(ibdy) {
+      return (j - 1) + m * (k - 1) + (i ? m * m : 0) +
+             offset;
+    }
+    offset += 2 * m * m;
+    if(jbdy) {
+      return (i - 1) + m * (k - 1) + (j ? m * m : 0) +
+             offset;
+    }
+    offset += 2 * m * m;
+    return (i - 1) + m * (j - 1) + (k ? m * m : 0) +
+           offset;
+  }
+  offset += 6 * m * m;
+  return offset + (i - 1) + m * ((j - 1) + m * (k - 1));
+}
+
+/* Points along the lattice segment from a to b with
+ * order - 1 interior points */
+template <int dim>
+void lattice_edge(const Array<int, dim> &a,
+                  const Array<int, dim> &b, int order,
+                  std::vector<Array<int, dim> > &nodes) {
+  for(int t = 1; t < order; t++) {
+    Array<int, dim> p;
+    for(int d = 0; d < dim; d++) {
+      p[d] = a[d] + (b[d] - a[d]) / order * t;
+    }
+    nodes.push_back(p);
+  }
+}
+
+/* Moves each corner of a lattice simplex one step towards
+ * each of the other corners */
+template <int dim, int ncorners>
+Array<Array<int, dim>, ncorners> shrink(
+    const Array<Array<int, dim>, ncorners> &c, int order) {
+  Array<Array<int, dim>, ncorners> inner;
+  for(int v = 0; v < ncorners; v++) {
+    for(int d = 0; d < dim; d++) {
+      inner[v][d] = c[v][d];
+      for(int w = 0; w < ncorners; w++) {
+        inner[v][d] += (c[w][d] - c[v][d]) / order;
+      }
+    }
+  }
+  return inner;
+}
+
+/* vtkHigherOrderTriangle node ordering: vertices, the edges
+ * (0, 1), (1, 2), (2, 0), then the interior ordered as a
+ * triangle of order - 3 */
+template <int dim>
+void triangle_nodes(const Array<Array<int, dim>, 3> &c,
+                    int order,
+                    std::vector<Array<int, dim> > &nodes) {
+  if(order < 0) {
+    return;
+  }
+  if(order == 0) {
+    nodes.push_back(c[0]);
+    return;
+  }
+  for(int v = 0; v < 3; v++) {
+    nodes.push_back(c[v]);
+  }
+  for(int e = 0; e < 3; e++) {
+    lattice_edge(c[e], c[(e + 1) % 3], order, nodes);
+  }
+  if(order >= 3) {
+    triangle_nodes(shrink<dim, 3>(c, order), order - 3,
+                   nodes);
+  }
+}
+
+/* vtkHigherOrderTetra node ordering: vertices, the edges
+ * (0, 1), (1, 2), (2, 0), (0, 3), (1, 3), (2, 3), the faces
+ * ordered as outward facing triangles, then the interior
+ * ordered as a tetrahedron of order - 4 */
+inline void tetra_nodes(
+    const Array<Array<int, 3>, 4> &c, int order,
+    std::vector<Array<int, 3> > &nodes) {
+  if(order < 0) {
+    return;
+  }
+  if(order == 0) {
+    nodes.push_back(c[0]);
+    return;
+  }
+  for(int v = 0; v < 4; v++) {
+    nodes.push_back(c[v]);
+  }
+  constexpr const int edges[6][2] = {
+      {0, 1}, {1, 2}, {2, 0}, {0, 3}, {1, 3}, {2, 3}};
+  for(int e = 0; e < 6; e++) {
+    lattice_edge(c[edges[e][0]], c[edges[e][1]], order,
+                 nodes);
+  }
+  if(order >= 3) {
+    constexpr const int faces[4][3] = {
+        {0, 1, 3}, {2, 3, 1}, {0, 3, 2}, {0, 2, 1}};
+    for(int f = 0; f < 4; f++) {
+      Array<Array<int, 3>, 3> face;
+      for(int v = 0; v < 3; v++) {
+        face[v] = c[faces[f][v]];
+      }
+      triangle_nodes(shrink<3, 3>(face, order), order - 3,
+                     nodes);
+    }
+  }
+  if(order >= 4) {
+    tetra_nodes(shrink<3, 4>(c, order), order - 4, nodes);
+  }
+}
+}  // namespace Internal
+
+template <>
+inline std::vector<Array<int, 2> > lagrange_nodes<2>(
+    CellShape shape, int order) {
+  std::vector<Array<int, 2> > nodes;
+  if(shape == CellShape::Box) {
+    nodes.resize((order + 1) * (order + 1));
+    for(int j = 0; j <= order; j++) {
+      for(int i = 0; i <= order; i++) {
+        nodes[Internal::box_node_index(i, j, order)] =
+            Array<int, 2>(i, j);
+      }
+    }
+  } else {
+    Array<Array<int, 2>, 3> c;
+    c[0] = Array<int, 2>(0, 0);
+    c[1] = Array<int, 2>(order, 0);
+    c[2] = Array<int, 2>(0, order);
+    Internal::triangle_nodes(c, order, nodes);
+  }
+  return nodes;
+}
+
+template <>
+inline std::vector<Array<int, 3> > lagrange_nodes<3>(
+    CellShape shape, int order) {
+  std::vector<Array<int, 3> > nodes;
+  if(shape == CellShape::Box) {
+    nodes.resize((order + 1) * (order + 1) * (order + 1));
+    for(int k = 0; k <= order; k++) {
+      for(int j = 0; j <= order; j++) {
+        for(int i = 0; i <= order; i++) {
+          nodes[Internal::box_node_index(i, j, k, order)] =
+              Array<int, 3>(i, j, k);
+        }
+      }
+    }
+  } else {
+    Array<Array<int, 3>, 4> c;
+    c[0] = Array<int, 3>(0, 0, 0);
+    c[1] = Array<int, 3>(order, 0, 0);
+    c[2] = Array<int, 3>(0, order, 0);
+    c[3] = Array<int, 3>(0, 0, order);
+    Internal::tetra_nodes(c, order, nodes);
+  }
+  return nodes;
+}
+
+/* Writes a field of per-element polynomials to a VTK XML
+ * unstructured grid (.vtu) of Lagrange cells, with the
+ * binary data appended either raw or zlib compressed.
+ *
+ * Each element is an affine image of the reference element
+ * given by its first dim + 1 vertices; for boxes these are
+ * the origin and its neighbors along each axis. The
+ * polynomial is evaluated in reference coordinates at the
+ * Lagrange nodes of the cell.
+ *
+ * Elements are buffered in chunks which are written out as
+ * separate pieces of the grid, so only one chunk is ever in
+ * memory. The XML header can only be written once every
+ * piece's size is known, so the appended data is streamed
+ * to a temporary file which is copied after the header.
+ *
+ * Call close() to see write errors; the destructor closes
+ * the file if it's still open, but can't report them.
+ */
+template <typename CoeffT, int _degree, int _dim>
+class VTUWriter {
+ public:
+  static_assert(_dim == 2 || _dim == 3,
+                "VTK only has 2D and 3D Lagrange cells");
+
+  using Poly = Polynomial<CoeffT, _degree, _dim>;
+  using Vertices = Array<Array<double, _dim>, _dim + 1>;
+
+  VTUWriter(const std::string &filename, CellShape shape,
+            int order = std::max(1, _degree),
+            VTUCompression compression =
+                VTUCompression::Raw,
+            const std::string &field_name = "u",
+            int chunk_elems = 4096)
+      : filename(filename),
+        data_filename(filename + ".appended"),
+        field_name(field_name),
+        shape(shape),
+        order(order),
+        compression(compression),
+        chunk_elems(chunk_elems),
+        chunk_count(0),
+        data_size(0),
+        closed(false) {
+    assert(order >= 1);
+    assert(chunk_elems >= 1);
+    const std::vector<Array<int, _dim> > lattice =
+        lagrange_nodes<_dim>(shape, order);
+    std::vector<Array<CoeffT, _dim> > points;
+    for(const Array<int, _dim> &l : lattice) {
+      Array<CoeffT, _dim> p;
+      for(int d = 0; d < _dim; d++) {
+        p[d] = CoeffT(l[d]) / CoeffT(order);
+      }
+      ref_nodes.push_back(p);
+      points.push_back(p);
+    }
+    nodes_per_cell = int(lattice.size());
+    sampled.resize(nodes_per_cell);
+    sampler = BatchEvaluator<CoeffT, _degree, _dim>(points);
+    data.open(data_filename.c_str(),
+              std::ios::binary | std::ios::trunc);
+    if(!data) {
+      throw std::runtime_error("Could not open " +
+                               data_filename);
+    }
+    positions.reserve(3 * nodes_per_cell * chunk_elems);
+    values.reserve(nodes_per_cell * chunk_elems);
+  }
+
+  VTUWriter(const VTUWriter &) = delete;
+  VTUWriter &operator=(const VTUWriter &) = delete;
+
+  /* Destructors can't throw, so errors closing the file
+   * here are dropped; the temporary file is still
+   * removed */
+  ~VTUWriter() {
+    if(!closed) {
+      try {
+        close();
+      } catch(...) {
+      }
+    }
+  }
+
+  int nodes_per_element() const noexcept {
+    return nodes_per_cell;
+  }
+
+  void write_element(const Vertices &vertices,
+                     const Poly &p) {
+    assert(!closed);
+    const int first = int(values.size());
+    values.resize(first + nodes_per_cell);
+    sampler.eval(p, sampled.data());
+    for(int n = 0; n < nodes_per_cell; n++) {
+      values[first + n] = double(sampled[n]);
+      for(int x = 0; x < 3; x++) {
+        double pos = 0.0;
+        if(x < _dim) {
+          pos = vertices[0][x];
+          for(int d = 0; d < _dim; d++) {
+            pos += (vertices[d + 1][x] - vertices[0][x]) *
+                   double(ref_nodes[n][d]);
+          }
+        }
+        positions.push_back(pos);
+      }
+    }
+    chunk_count++;
+    if(chunk_count == chunk_elems) {
+      flush_piece();
+    }
+  }
+
+  /* Writes the final file; nothing can be written after.
+   * Throws std::runtime_error if it can't be written, after
+   * removing the temporary file */
+  void close() {
+    assert(!closed);
+    closed = true;
+    try {
+      write_file();
+    } catch(...) {
+      data.close();
+      std::remove(data_filename.c_str());
+      throw;
+    }
+  }
+
+ private:
+  struct Piece {
+    long points;
+    long cells;
+    Array<std::uint64_t, 5> offsets;
+  };
+
+  void write_file() {
+    flush_piece();
+    data.close();
+
+    std::ofstream out(filename.c_str(),
+                      std::ios::binary | std::ios::trunc);
+    if(!out) {
+      throw std::runtime_error("Could not open " +
+                               filename);
+    }
+    out << "<?xml version=\"1.0\"?>\n"
+        << "<VTKFile type=\"UnstructuredGrid\" "
+           "version=\"1.0\" byte_order=\"LittleEndian\" "
+           "header_type=\"UInt64\"";
+    if(compression == VTUCompression::ZLib) {
+      out << " compressor=\"vtkZLibDataCompressor\"";
+    }
+    out << ">\n  <UnstructuredGrid>\n";
+    for(const Piece &piece : pieces) {
+      out << "    <Piece NumberOfPoints=\"" << piece.points
+          << "\" NumberOfCells=\"" << piece.cells << "\">\n"
+          << "      <PointData Scalars=\"" << field_name
+          << "\">\n";
+      data_array(out, "Float64", field_name, 1,
+                 piece.offsets[0]);
+      out << "      </PointData>\n      <Points>\n";
+      data_array(out, "Float64", "Points", 3,
+                 piece.offsets[1]);
+      out << "      </Points>\n      <Cells>\n";
+      data_array(out, "Int64", "connectivity", 1,
+                 piece.offsets[2]);
+      data_array(out, "Int64", "offsets", 1,
+                 piece.offsets[3]);
+      data_array(out, "UInt8", "types", 1,
+                 piece.offsets[4]);
+      out << "      </Cells>\n    </Piece>\n";
+    }
+    out << "  </UnstructuredGrid>\n"
+        << "  <AppendedData encoding=\"raw\">\n_";
+    std::ifstream appended(data_filename.c_str(),
+                           std::ios::binary);
+    if(data_size > 0) {
+      out << appended.rdbuf();
+    }
+    appended.close();
+    std::remove(data_filename.c_str());
+    out << "\n  </AppendedData>\n</VTKFile>\n";
+    if(!out) {
+      throw std::runtime_error("Failed writing " +
+                               filename);
+    }
+  }
+
+  static void data_array(std::ostream &out,
+                         const char *type,
+                         const std::string &name,
+                         int components,
+                         std::uint64_t offset) {
+    out << "        <DataArray type=\"" << type
+        << "\" Name=\"" << name << "\"";
+    if(components > 1) {
+      out << " NumberOfComponents=\"" << components << "\"";
+    }
+    out << " format=\"appended\" offset=\"" << offset
+        << "\"/>\n";
+  }
+
+  int cell_type() const noexcept {
+    if(_dim == 2) {
+      return shape == CellShape::Box ? 70 : 69;
+    } else {
+      return shape == CellShape::Box ? 72 : 71;
+    }
+  }
+
+  void flush_piece() {
+    if(chunk_count == 0) {
+      return;
+    }
+    Piece piece;
+    piece.cells = chunk_count;
+    piece.points = long(chunk_count) * nodes_per_cell;
+    std::vector<std::int64_t> connectivity(piece.points);
+    for(long i = 0; i < piece.points; i++) {
+      connectivity[i] = i;
+    }
+    std::vector<std::int64_t> offsets(piece.cells);
+    for(long c = 0; c < piece.cells; c++) {
+      offsets[c] = (c + 1) * nodes_per_cell;
+    }
+    std::vector<std::uint8_t> types(
+        piece.cells, std::uint8_t(cell_type()));
+    piece.offsets[0] = append(values);
+    piece.offsets[1] = append(positions);
+    piece.offsets[2] = append(connectivity);
+    piece.offsets[3] = append(offsets);
+    piece.offsets[4] = append(types);
+    pieces.push_back(piece);
+
+    values.clear();
+    positions.clear();
+    chunk_count = 0;
+  }
+
+  /* Appends one data array to the data file, returning its
+   * offset */
+  template <typename T>
+  std::uint64_t append(const std::vector<T> &array) {
+    const std::uint64_t offset = data_size;
+    const std::uint64_t bytes = array.size() * sizeof(T);
+    const char *src =
+        reinterpret_cast<const char *>(array.data());
+    if(compression == VTUCompression::Raw) {
+      write_raw(&bytes, sizeof(bytes));
+      write_raw(src, bytes);
+      return offset;
+    }
+    /* VTK's compressed format: the number of blocks, the
+     * uncompressed block size, the size of the last block,
+     * the compressed size of each block, then the blocks */
+    constexpr const std::uint64_t block_size = 1 << 15;
+    const std::uint64_t num_blocks =
+        (bytes + block_size - 1) / block_size;
+    std::vector<std::uint64_t> header(3 + num_blocks);
+    header[0] = num_blocks;
+    header[1] = block_size;
+    header[2] = (bytes % block_size == 0 && bytes > 0)
+                    ? block_size
+                    : bytes % block_size;
+    std::vector<std::vector<Bytef> > blocks(num_blocks);
+    for(std::uint64_t b = 0; b < num_blocks; b++) {
+      const std::uint64_t len =
+          std::min(block_size, bytes - b * block_size);
+      uLongf compressed_len = compressBound(uLong(len));
+      blocks[b].resize(compressed_len);
+      const int status = compress2(
+          blocks[b].data(), &compressed_len,
+          reinterpret_cast<const Bytef *>(src +
+                                          b * block_size),
+          uLong(len), Z_DEFAULT_COMPRESSION);
+      if(status != Z_OK) {
+        throw std::runtime_error("zlib compression failed");
+      }
+      blocks[b].resize(compressed_len);
+      header[3 + b] = compressed_len;
+    }
+    write_raw(header.data(),
+              header.size() * sizeof(std::uint64_t));
+    for(const auto &block : blocks) {
+      write_raw(block.data(), block.size());
+    }
+    return offset;
+  }
+
+  void write_raw(const void *src, std::uint64_t bytes) {
+    data.write(static_cast<const char *>(src),
+               std::streamsize(bytes));
+    if(!data) {
+      throw std::runtime_error("Failed writing " +
+                               data_filename);
+    }
+    data_size += bytes;
+  }
+
+  std::string filename;
+  std::string data_filename;
+  std::string field_name;
+  CellShape shape;
+  int order;
+  VTUCompression compression;
+  int chunk_elems;
+
+  int nodes_per_cell;
+  std::vector<Array<CoeffT, _dim> > ref_nodes;
+  BatchEvaluator<CoeffT, _degree, _dim> sampler;
+  std::vector<CoeffT> sampled;
+
+  std::ofstream data;
+  int chunk_count;
+  std::uint64_t data_size;
+  std::vector<double> values;
+  std::vector<double> positions;
+  std::vector<Piece> pieces;
+  bool closed;
+};
+}  // namespace IO
+}  // namespace Numerical
+
+#endif  // _VTU_WRITER_HPP_
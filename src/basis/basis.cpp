@@ -1,18 +1,32 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
 
+#include "fraction.hpp"
+#include "kernel_codegen.hpp"
 #include "polynomial.hpp"
+#include "polynomial_integrate.hpp"
 
 constexpr const int dim = 3;
 using CoeffT = double;
+/* The basis is orthogonalized in exact arithmetic, and
+ * only rounded to CoeffT when it's normalized */
+using ExactT = Numerical::Fraction;
 
 template <typename P1, typename P2>
-CoeffT dot_product(const P1 &x, const P2 &y) {
-  auto idp =
-      x.product(y).integrate(0).integrate(1).integrate(2);
-
-  return idp.eval(1.0, 1.0, 1.0) - idp.eval(0.0, 0.0, 0.0);
+auto dot_product(const P1 &x, const P2 &y) {
+  /* The inner product over the unit cube */
+  const auto p = x.product(y);
+  using ProductT =
+      typename std::decay<decltype(*p.data())>::type;
+  const Array<ProductT, dim> lo((Tags::Zero_Tag()));
+  const Array<ProductT, dim> hi(1, 1, 1);
+  return Numerical::integrate_box(p, lo, hi);
 }
 
 template <typename real, typename integer>
@@ -95,84 +109,154 @@ P1 orthogonal_helper(const P1 &p, const P2 &next,
 template <typename P1, typename... P_Prior>
 P1 orthogonal(const P1 &p, P_Prior... prior_basis) {
   P1 projected = orthogonal_helper(p, prior_basis...);
-  P1 unscaled = p + (-projected);
-  return unscaled *
-         std::sqrt(1.0 / dot_product(unscaled, unscaled));
+  return p + (-projected);
+}
+
+template <int degree>
+Numerical::Polynomial<CoeffT, degree, dim> normalize(
+    const Numerical::Polynomial<ExactT, degree, dim> &p) {
+  /* The normalized coefficient c / |p| is irrational, so
+   * it can't be rounded just once; this takes the square
+   * root of the exact c^2 / |p|^2 rounded once, which is
+   * within 3/4 of an ulp */
+  const ExactT norm_sq = dot_product(p, p);
+  Numerical::Polynomial<CoeffT, degree, dim> n;
+  for(int k = 0; k < p.num_coeffs; k++) {
+    const ExactT &c = p.data()[k];
+    const CoeffT magnitude =
+        std::sqrt(CoeffT(c * c / norm_sq));
+    n.data()[k] = c < ExactT(0) ? -magnitude : magnitude;
+  }
+  return n;
+}
+
+template <int degree>
+Numerical::Polynomial<CoeffT, 2, dim> widen(
+    const Numerical::Polynomial<CoeffT, degree, dim> &p) {
+  /* Storage is graded, so the lower degree coefficients
+   * are a prefix of the higher degree ones */
+  Numerical::Polynomial<CoeffT, 2, dim> w(
+      (Tags::Zero_Tag()));
+  for(int k = 0; k < p.num_coeffs; k++) {
+    w.data()[k] = p.data()[k];
+  }
+  return w;
 }
 
 int main(int argc, char **argv) {
-  Numerical::Polynomial<CoeffT, 0, dim> constant;
-  constant.coeff(0, 0, 0) = 1.0;
-  using linear_p = Numerical::Polynomial<CoeffT, 1, dim>;
+  /* basis --emit-header <path> writes straight-line
+   * kernels for the basis to path, in a namespace named
+   * after the file */
+  const char *header_path = nullptr;
+  if(argc == 3 &&
+     std::strcmp(argv[1], "--emit-header") == 0) {
+    header_path = argv[2];
+  } else if(argc != 1) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--emit-header <path>]" << std::endl;
+    return 1;
+  }
+
+  Numerical::Polynomial<ExactT, 0, dim> constant;
+  constant.coeff(0, 0, 0) = 1;
+  using linear_p = Numerical::Polynomial<ExactT, 1, dim>;
   linear_p linearx((Tags::Zero_Tag()));
   linear_p lineary((Tags::Zero_Tag()));
   linear_p linearz((Tags::Zero_Tag()));
-  linearx.coeff(0, 0, 1) = 1.0;
-  lineary.coeff(0, 1, 0) = 1.0;
-  linearz.coeff(1, 0, 0) = 1.0;
+  linearx.coeff(0, 0, 1) = 1;
+  lineary.coeff(0, 1, 0) = 1;
+  linearz.coeff(1, 0, 0) = 1;
 
   linear_p lx_o_c = orthogonal(linearx, constant);
   linear_p ly_o_c = orthogonal(lineary, constant, lx_o_c);
   linear_p lz_o_c =
       orthogonal(linearz, constant, lx_o_c, ly_o_c);
 
-  using quadratic_p = Numerical::Polynomial<CoeffT, 2, dim>;
+  using quadratic_p = Numerical::Polynomial<ExactT, 2, dim>;
   quadratic_p quad_xx((Tags::Zero_Tag()));
-  quad_xx.coeff(2, 0, 0) = 1.0;
+  quad_xx.coeff(2, 0, 0) = 1;
   quadratic_p quad_o_xx =
       orthogonal(quad_xx, constant, lx_o_c, ly_o_c, lz_o_c);
 
   quadratic_p quad_xy((Tags::Zero_Tag()));
-  quad_xy.coeff(1, 1, 0) = 1.0;
+  quad_xy.coeff(1, 1, 0) = 1;
   quadratic_p quad_o_xy = orthogonal(
       quad_xy, constant, lx_o_c, ly_o_c, lz_o_c, quad_o_xx);
 
   quadratic_p quad_xz((Tags::Zero_Tag()));
-  quad_xz.coeff(1, 0, 1) = 1.0;
+  quad_xz.coeff(1, 0, 1) = 1;
   quadratic_p quad_o_xz =
       orthogonal(quad_xz, constant, lx_o_c, ly_o_c, lz_o_c,
                  quad_o_xx, quad_o_xy);
 
   quadratic_p quad_yy((Tags::Zero_Tag()));
-  quad_yy.coeff(0, 2, 0) = 1.0;
+  quad_yy.coeff(0, 2, 0) = 1;
   quadratic_p quad_o_yy =
       orthogonal(quad_yy, constant, lx_o_c, ly_o_c, lz_o_c,
                  quad_o_xx, quad_o_xy, quad_o_xz);
 
   quadratic_p quad_yz((Tags::Zero_Tag()));
-  quad_yz.coeff(0, 1, 1) = 1.0;
+  quad_yz.coeff(0, 1, 1) = 1;
   quadratic_p quad_o_yz = orthogonal(
       quad_yz, constant, lx_o_c, ly_o_c, lz_o_c, quad_o_xx,
       quad_o_xy, quad_o_xz, quad_o_yy);
 
   quadratic_p quad_zz((Tags::Zero_Tag()));
-  quad_zz.coeff(0, 0, 2) = 1.0;
+  quad_zz.coeff(0, 0, 2) = 1;
   quadratic_p quad_o_zz = orthogonal(
       quad_zz, constant, lx_o_c, ly_o_c, lz_o_c, quad_o_xx,
       quad_o_xy, quad_o_xz, quad_o_yy, quad_o_yz);
 
-  using cubic_p = Numerical::Polynomial<CoeffT, 3, dim>;
-  
-  quadratic_p exp_proj =
-      exp_dot_product(constant) * constant +
-      exp_dot_product(lx_o_c) * lx_o_c +
-      exp_dot_product(ly_o_c) * ly_o_c +
-      exp_dot_product(lz_o_c) * lz_o_c +
-      exp_dot_product(quad_o_xx) * quad_o_xx +
-      exp_dot_product(quad_o_xy) * quad_o_xy +
-      exp_dot_product(quad_o_xz) * quad_o_xz +
-      exp_dot_product(quad_o_yy) * quad_o_yy +
-      exp_dot_product(quad_o_yz) * quad_o_yz +
-      exp_dot_product(quad_o_zz) * quad_o_zz;
+  const auto basis_c = normalize(constant);
+  const auto basis_x = normalize(lx_o_c);
+  const auto basis_y = normalize(ly_o_c);
+  const auto basis_z = normalize(lz_o_c);
+  const auto basis_xx = normalize(quad_o_xx);
+  const auto basis_xy = normalize(quad_o_xy);
+  const auto basis_xz = normalize(quad_o_xz);
+  const auto basis_yy = normalize(quad_o_yy);
+  const auto basis_yz = normalize(quad_o_yz);
+  const auto basis_zz = normalize(quad_o_zz);
+
+  if(header_path != nullptr) {
+    std::string name(header_path);
+    name = name.substr(name.find_last_of('/') + 1);
+    name = name.substr(0, name.find('.'));
+    std::ofstream header(header_path);
+    Numerical::IO::write_kernel_header(
+        header, name,
+        std::vector<Numerical::Polynomial<CoeffT, 2, dim> >{
+            widen(basis_c), widen(basis_x), widen(basis_y),
+            widen(basis_z), basis_xx, basis_xy, basis_xz,
+            basis_yy, basis_yz, basis_zz});
+    if(!header) {
+      std::cerr << "Couldn't write " << header_path
+                << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  Numerical::Polynomial<CoeffT, 2, dim> exp_proj =
+      exp_dot_product(basis_c) * basis_c +
+      exp_dot_product(basis_x) * basis_x +
+      exp_dot_product(basis_y) * basis_y +
+      exp_dot_product(basis_z) * basis_z +
+      exp_dot_product(basis_xx) * basis_xx +
+      exp_dot_product(basis_xy) * basis_xy +
+      exp_dot_product(basis_xz) * basis_xz +
+      exp_dot_product(basis_yy) * basis_yy +
+      exp_dot_product(basis_yz) * basis_yz +
+      exp_dot_product(basis_zz) * basis_zz;
 
   constexpr CoeffT optimal_dp =
       32.6001889612617945069684599145663334796335791191178;
   std::cout << "Exponent Projection: "
             << exp_dot_product(exp_proj) << " vs "
             << optimal_dp << "; "
-            << exp_dot_product(exp_proj + 0.001 * lx_o_c)
+            << exp_dot_product(exp_proj + 0.001 * basis_x)
             << "; "
-            << exp_dot_product(exp_proj + -0.001 * lx_o_c)
+            << exp_dot_product(exp_proj + -0.001 * basis_x)
             << "; " << std::endl
             << dot_product(exp_proj, exp_proj) << std::endl;
   exp_proj.coeff_iterator(
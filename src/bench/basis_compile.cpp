@@ -0,0 +1,26 @@
+/* Instantiates the unit basis of one degree and dimension;
+ * compiled by basis_compile_bench.cmake to time the
+ * template instantiation */
+
+#include "polynomial.hpp"
+
+#ifndef BENCH_DEGREE
+#define BENCH_DEGREE 4
+#endif
+
+#ifndef BENCH_DIM
+#define BENCH_DIM 3
+#endif
+
+using basis_t = Numerical::Utilities::basis_tuple<
+    double, BENCH_DEGREE, BENCH_DIM>::tuple_type;
+
+static basis_t basis;
+
+int main(int argc, char **argv) {
+  Array<int, BENCH_DIM> exponents;
+  Numerical::Utilities::BasisGenerators<
+      double, BENCH_DEGREE,
+      BENCH_DIM>::unit_basis(basis, exponents);
+  return 0;
+}
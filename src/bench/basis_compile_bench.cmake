@@ -0,0 +1,48 @@
+# Times compiling the unit basis for each degree and
+# dimension; run through the basis_compile_bench target, or
+# cmake -DCXX=<compiler> -DSOURCE_DIR=<repo> -P <this file>
+
+cmake_minimum_required(VERSION 3.23)
+
+if(NOT DEFINED MAX_DEGREE)
+  set(MAX_DEGREE 8)
+endif()
+
+if(NOT DEFINED MAX_DIM)
+  set(MAX_DIM 4)
+endif()
+
+message("degree dim basis_size seconds")
+
+foreach(dim RANGE 1 ${MAX_DIM})
+  foreach(degree RANGE 1 ${MAX_DEGREE})
+    string(TIMESTAMP start "%s%f")
+    execute_process(
+      COMMAND ${CXX} -std=c++14 -fsyntax-only
+              -I${SOURCE_DIR}/include
+              -DBENCH_DEGREE=${degree} -DBENCH_DIM=${dim}
+              ${SOURCE_DIR}/src/bench/basis_compile.cpp
+      RESULT_VARIABLE result
+      ERROR_VARIABLE errors)
+    string(TIMESTAMP stop "%s%f")
+    if(NOT result EQUAL 0)
+      message(FATAL_ERROR
+              "degree ${degree} dim ${dim} failed:\n${errors}")
+    endif()
+    # The number of basis functions, (degree + dim) choose dim
+    set(size 1)
+    foreach(i RANGE 1 ${dim})
+      math(EXPR size "${size} * (${degree} + ${i}) / ${i}")
+    endforeach()
+    math(EXPR usec "${stop} - ${start}")
+    math(EXPR whole "${usec} / 1000000")
+    math(EXPR frac "(${usec} % 1000000) / 1000")
+    string(LENGTH "${frac}" frac_len)
+    if(frac_len EQUAL 1)
+      set(frac "00${frac}")
+    elseif(frac_len EQUAL 2)
+      set(frac "0${frac}")
+    endif()
+    message("${degree} ${dim} ${size} ${whole}.${frac}")
+  endforeach()
+endforeach()
@@ -0,0 +1,117 @@
+/* Times the straight-line kernels basis --emit-header
+ * generates against Polynomial::eval on the same basis,
+ * after checking they agree */
+
+#include "basis_kernel.hpp"
+#include "polynomial.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using Poly =
+    Numerical::Polynomial<double, basis_kernel::degree,
+                          basis_kernel::dim>;
+
+static_assert(Poly::num_coeffs == basis_kernel::num_coeffs,
+              "The generated basis has a different degree "
+              "or dimension");
+
+/* The best time in nanoseconds per point of tabulating
+ * the points with f */
+template <typename Func>
+double time_nsec(int num_points, Func &&f) {
+  using clock = std::chrono::steady_clock;
+  double best = 1e300;
+  for(int rep = 0; rep < 20; rep++) {
+    const auto start = clock::now();
+    f();
+    const double nsec =
+        std::chrono::duration<double, std::nano>(
+            clock::now() - start)
+            .count();
+    best = std::min(best, nsec / num_points);
+  }
+  return best;
+}
+
+int main() {
+  constexpr const int num_points = 1 << 16;
+  constexpr const int nf = basis_kernel::num_functions;
+  constexpr const int dim = basis_kernel::dim;
+  std::vector<Poly> basis(nf);
+  for(int f = 0; f < nf; f++) {
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      basis[f].data()[k] = basis_kernel::coefficients[f][k];
+    }
+  }
+  std::mt19937_64 rng(48);
+  std::uniform_real_distribution<double> pdf(0.0, 1.0);
+  std::vector<double> points(num_points * dim);
+  for(double &x : points) {
+    x = pdf(rng);
+  }
+  std::vector<double> generic(num_points * nf);
+  std::vector<double> generated(num_points * nf);
+  std::vector<double> gradients(num_points * nf * dim);
+
+  auto tabulate_generic = [&] {
+    for(int p = 0; p < num_points; p++) {
+      const double *x = &points[p * dim];
+      for(int f = 0; f < nf; f++) {
+        generic[p * nf + f] =
+            basis[f].eval(x[0], x[1], x[2]);
+      }
+    }
+  };
+  auto tabulate_generated = [&] {
+    basis_kernel::tabulate(points.data(), num_points,
+                           generated.data());
+  };
+  auto tabulate_gradient = [&] {
+    basis_kernel::tabulate_with_gradient(
+        points.data(), num_points, generated.data(),
+        gradients.data());
+  };
+
+  tabulate_generic();
+  tabulate_gradient();
+  double max_err = 0.0;
+  for(int p = 0; p < num_points; p++) {
+    const double *x = &points[p * dim];
+    for(int f = 0; f < nf; f++) {
+      max_err = std::max(
+          max_err, std::abs(generic[p * nf + f] -
+                            generated[p * nf + f]));
+      for(int v = 0; v < dim; v++) {
+        const double d = basis[f].differentiate(v).eval(
+            x[0], x[1], x[2]);
+        const double g = gradients[(p * nf + f) * dim + v];
+        max_err = std::max(max_err, std::abs(d - g));
+      }
+    }
+  }
+  std::printf("max error %.3e\n", max_err);
+  if(max_err > 1e-12) {
+    std::printf("The generated kernel doesn't match\n");
+    return 1;
+  }
+
+  const double generic_ns =
+      time_nsec(num_points, tabulate_generic);
+  const double generated_ns =
+      time_nsec(num_points, tabulate_generated);
+  const double gradient_ns =
+      time_nsec(num_points, tabulate_gradient);
+  std::printf("Polynomial::eval %.2f ns/point\n",
+              generic_ns);
+  std::printf("generated eval %.2f ns/point, %.1fx\n",
+              generated_ns, generic_ns / generated_ns);
+  std::printf(
+      "generated eval_with_gradient %.2f ns/point\n",
+      gradient_ns);
+  return 0;
+}
@@ -0,0 +1,99 @@
+/* Times Polynomial::product against fft_product for
+ * products of polynomials of each pair of degrees and
+ * dimension, to find the crossover use_fft_product's cost
+ * model is calibrated against; terms is the number of
+ * pairs of terms the dense product multiplies */
+
+#include "polynomial_fft.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#ifndef BENCH_MAX_DEGREE
+#define BENCH_MAX_DEGREE 16
+#endif
+
+using Numerical::Polynomial;
+
+static std::mt19937_64 rng(46);
+
+/* The average time in microseconds of calls to f */
+template <typename Func>
+double time_usec(Func &&f) {
+  using clock = std::chrono::steady_clock;
+  int reps = 1;
+  while(true) {
+    const auto start = clock::now();
+    for(int i = 0; i < reps; i++) {
+      f();
+    }
+    const double usec =
+        std::chrono::duration<double, std::micro>(
+            clock::now() - start)
+            .count();
+    if(usec > 1e5) {
+      return usec / reps;
+    }
+    reps *= 2;
+  }
+}
+
+template <int degree, int other_degree, int dim>
+void bench_product() {
+  using Poly = Polynomial<double, degree, dim>;
+  using Other = Polynomial<double, other_degree, dim>;
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  Poly p;
+  Other q;
+  for(int k = 0; k < Poly::num_coeffs; k++) {
+    p.data()[k] = pdf(rng);
+  }
+  for(int k = 0; k < Other::num_coeffs; k++) {
+    q.data()[k] = pdf(rng);
+  }
+  volatile double sink = 0.0;
+  const double dense = time_usec(
+      [&] { sink = sink + p.product(q).data()[0]; });
+  const double fft = time_usec([&] {
+    sink = sink + Numerical::fft_product(p, q).data()[0];
+  });
+  std::printf(
+      "%d %d %d %d %.3f %.3f %s\n", degree, other_degree,
+      dim, Poly::num_coeffs * Other::num_coeffs, dense, fft,
+      Numerical::use_fft_product<double, degree,
+                                 other_degree, dim>()
+          ? "fft"
+          : "dense");
+}
+
+/* Squares, products with a polynomial of half the degree,
+ * and products with a linear polynomial, which is the
+ * case the dense product is best at */
+template <int degree, int dim>
+struct BenchDegrees {
+  static void run() {
+    BenchDegrees<degree - 1, dim>::run();
+    bench_product<degree, degree, dim>();
+    if(degree / 2 > 1) {
+      bench_product<degree, degree / 2, dim>();
+    }
+    if(degree > 1) {
+      bench_product<degree, 1, dim>();
+    }
+  }
+};
+
+template <int dim>
+struct BenchDegrees<0, dim> {
+  static void run() {}
+};
+
+int main() {
+  std::printf("degree other_degree dim terms dense_usec "
+              "fft_usec model\n");
+  BenchDegrees<BENCH_MAX_DEGREE, 1>::run();
+  BenchDegrees<BENCH_MAX_DEGREE, 2>::run();
+  BenchDegrees<BENCH_MAX_DEGREE, 3>::run();
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include <iostream>
+#include <vector>
+
+#include <mpi.h>
+
+#include "halo_exchange.hpp"
+#include "polynomial.hpp"
+
+/* Exchanges the halos of a partitioned element grid and
+ * checks every ghost arrived intact
+ * Run with ie. mpirun -np 4 ./halo
+ */
+
+constexpr const int dim = 2;
+using CoeffT = double;
+using Poly = Numerical::Polynomial<CoeffT, 2, dim>;
+
+void fill(Poly &p, int global) {
+  int i = 0;
+  p.coeff_iterator([&](const Array<int, dim> &exponents) {
+    p.coeff(exponents) = global + 0.125 * i;
+    i++;
+  });
+}
+
+bool check(const Poly &p, int global) {
+  Poly expected;
+  fill(expected, global);
+  bool match = true;
+  p.coeff_iterator([&](const Array<int, dim> &exponents) {
+    match = match &&
+            p.coeff(exponents) == expected.coeff(exponents);
+  });
+  return match;
+}
+
+int main(int argc, char **argv) {
+  MPI_Init(&argc, &argv);
+  int rank, num_ranks;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+
+  const Array<int, dim> cells(24, 17);
+  const Array<int, dim> rank_grid =
+      Numerical::Parallel::balanced_rank_grid(num_ranks,
+                                              cells);
+  int failures = 0;
+  for(int layers = 1; layers <= 2; layers++) {
+    Numerical::Parallel::CartesianPartition<dim> part(
+        cells, rank_grid, rank, layers);
+    std::vector<Poly> elems(part.num_local(),
+                            Poly((Tags::Zero_Tag())));
+    for(int i = 0; i < part.num_owned(); i++) {
+      fill(elems[i], part.global_index(i));
+    }
+
+    Numerical::Parallel::HaloExchange<Poly, dim> halo(part);
+    /* The interior is computed on while the halo is in
+     * flight, the boundary after it arrives */
+    CoeffT owned_sum = 0.0;
+    auto kernel = [&](int lo, int hi) {
+      for(int i = lo; i < hi; i++) {
+        owned_sum += elems[i].eval(0.5, 0.5);
+      }
+    };
+    halo.overlap(elems, kernel, kernel);
+    for(int i = part.num_owned(); i < part.num_local();
+        i++) {
+      if(!check(elems[i], part.global_index(i))) {
+        failures++;
+      }
+    }
+
+    int ghosts = part.num_ghost(), total_ghosts = 0;
+    MPI_Reduce(&ghosts, &total_ghosts, 1, MPI_INT, MPI_SUM,
+               0, MPI_COMM_WORLD);
+    if(rank == 0) {
+      std::cout << "Rank grid " << rank_grid << ", "
+                << layers << " ghost layers: "
+                << total_ghosts << " ghosts exchanged"
+                << std::endl;
+    }
+  }
+
+  int total_failures = 0;
+  MPI_Allreduce(&failures, &total_failures, 1, MPI_INT,
+                MPI_SUM, MPI_COMM_WORLD);
+  if(rank == 0) {
+    std::cout << (total_failures == 0 ? "Passed" : "Failed")
+              << ": " << total_failures << " bad ghosts"
+              << std::endl;
+  }
+  MPI_Finalize();
+  return total_failures == 0 ? 0 : 1;
+}
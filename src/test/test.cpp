@@ -1,12 +1,44 @@
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 
 #include <random>
 
+#include <affine_map.hpp>
 #include <array.hpp>
+#include <basis_tabulation.hpp>
+#include <bernstein.hpp>
 #include <ctmath.hpp>
+#include <double_double.hpp>
+#include <dual.hpp>
+#include <dynamic_polynomial.hpp>
+#include <face_trace.hpp>
+#include <fraction.hpp>
+#include <kernel_codegen.hpp>
+#include <orthogonal_polynomial.hpp>
+#include <parallel.hpp>
+#include <partition.hpp>
 #include <polynomial.hpp>
+#include <polynomial_batch.hpp>
+#include <polynomial_eval.hpp>
+#include <polynomial_fft.hpp>
+#include <polynomial_fit.hpp>
+#include <polynomial_integrate.hpp>
+#include <quadrature.hpp>
+#include <simd.hpp>
+#include <sparse_polynomial.hpp>
+#include <time_integration.hpp>
+#include <vector_polynomial.hpp>
+#include <vtu_writer.hpp>
 
 #include <typeinfo>
 
@@ -103,6 +135,21 @@ TEST_CASE("Compute Unit Basis", "[Polynomial]") {
   REQUIRE(quad_b3.coeff(2, 0) == 0.0);
   REQUIRE(quad_b3.coeff(1, 1) == 0.0);
   REQUIRE(quad_b3.coeff(0, 2) == 1.0);
+
+  /* The highest degree functions are generated as well */
+  const Array<int, dim> cubic_exps[4] = {
+      {3, 0}, {2, 1}, {1, 2}, {0, 3}};
+  const Polynomial<double, 3, dim> *cubic[4] = {
+      &std::get<6>(basis), &std::get<7>(basis),
+      &std::get<8>(basis), &std::get<9>(basis)};
+  for(int i = 0; i < 4; i++) {
+    cubic[i]->coeff_iterator(
+        [&](const Array<int, dim> &exponents) {
+          const double expected =
+              (exponents == cubic_exps[i]) ? 1.0 : 0.0;
+          REQUIRE(cubic[i]->coeff(exponents) == expected);
+        });
+  }
 }
 
 TEST_CASE("Change Polynomial Degree", "[Polynomial]") {
@@ -707,3 +754,1991 @@ TEST_CASE("Coefficient Indices", "[Polynomial]") {
     }
   }
 }
+
+TEST_CASE("Parallel Element Loops", "[Parallel]") {
+  constexpr const int num_elems = 1000;
+  using CoeffT = double;
+  using P = Polynomial<CoeffT, 2, 2>;
+
+  SECTION("Every element visited once") {
+    Parallel::Scheduler sched(4);
+    std::vector<int> visits(num_elems, 0);
+    /* Make the work imbalanced so stealing kicks in */
+    sched.parallel_for(
+        0, num_elems, [&](int e, int thread) {
+          volatile CoeffT sink = 0.0;
+          for(int i = 0; i < (e < 100 ? 1000 : 1); i++) {
+            sink = sink + CoeffT(i);
+          }
+          visits[e]++;
+        });
+    for(int e = 0; e < num_elems; e++) {
+      REQUIRE(visits[e] == 1);
+    }
+  }
+
+  SECTION("Deterministic reduction") {
+    std::mt19937_64 engine(42);
+    std::uniform_real_distribution<CoeffT> pdf(-1.0, 1.0);
+    std::vector<P> elems(num_elems);
+    for(P &p : elems) {
+      p.coeff_iterator([&](const Array<int, 2> &exponents) {
+        p.coeff(exponents) = pdf(engine);
+      });
+    }
+    auto reduce = [&](int num_threads) {
+      Parallel::Scheduler sched(num_threads);
+      return sched.reduce(
+          0, num_elems, CoeffT(0.0),
+          [&](int e, int thread) {
+            Parallel::ScratchArena &arena =
+                sched.arena(thread);
+            P *scaled = arena.create<P>(elems[e] * 0.5);
+            CoeffT v = scaled->eval(0.25, 0.75);
+            arena.reset();
+            return v;
+          },
+          [](CoeffT a, CoeffT b) { return a + b; });
+    };
+    const CoeffT serial = reduce(1);
+    for(int num_threads = 2; num_threads <= 8;
+        num_threads *= 2) {
+      REQUIRE(reduce(num_threads) == serial);
+    }
+  }
+
+  SECTION("Nested loops") {
+    Parallel::Scheduler sched(3);
+    std::vector<int> visits(num_elems, 0);
+    std::vector<int> same_thread(num_elems, 0);
+    sched.parallel_for(0, 10, [&](int outer, int thread) {
+      sched.parallel_for(0, 100, [&](int inner, int t) {
+        same_thread[outer * 100 + inner] = (t == thread);
+        visits[outer * 100 + inner]++;
+      });
+    });
+    for(int e = 0; e < num_elems; e++) {
+      REQUIRE(visits[e] == 1);
+      REQUIRE(same_thread[e] == 1);
+    }
+  }
+
+  SECTION("Exceptions") {
+    Parallel::Scheduler sched(4);
+    /* Throws from the calling thread and the workers */
+    for(int rep = 0; rep < 20; rep++) {
+      REQUIRE_THROWS_AS(
+          sched.parallel_for(0, num_elems,
+                             [&](int e, int thread) {
+                               if(e % 100 == 0) {
+                                 throw std::runtime_error(
+                                     "element failed");
+                               }
+                             }),
+          std::runtime_error);
+    }
+    /* The pool is still usable afterwards */
+    std::vector<int> visits(num_elems, 0);
+    sched.parallel_for(
+        0, num_elems, [&](int e, int) { visits[e]++; });
+    for(int e = 0; e < num_elems; e++) {
+      REQUIRE(visits[e] == 1);
+    }
+  }
+}
+
+TEST_CASE("Cartesian Partition", "[Parallel]") {
+  constexpr const int dim = 2;
+  constexpr const int num_ranks = 6;
+  const Array<int, dim> cells(13, 9);
+  const Array<int, dim> rank_grid =
+      Parallel::balanced_rank_grid(num_ranks, cells);
+  REQUIRE(rank_grid[0] * rank_grid[1] == num_ranks);
+  REQUIRE(rank_grid[0] == 3);
+
+  using Part = Parallel::CartesianPartition<dim>;
+  for(int layers = 1; layers <= 2; layers++) {
+    std::vector<Part> parts;
+    for(int r = 0; r < num_ranks; r++) {
+      parts.emplace_back(cells, rank_grid, r, layers);
+    }
+    std::vector<int> owners(cells[0] * cells[1], 0);
+    for(const Part &part : parts) {
+      for(int i = 0; i < part.num_owned(); i++) {
+        owners[part.global_index(i)]++;
+        REQUIRE(part.owner(part.cell_coords(
+                    part.global_index(i))) == part.rank());
+      }
+      for(const auto &n : part.neighbors()) {
+        /* The neighbor sends exactly the ghosts we expect,
+         * in the same order */
+        const Part &other = parts[n.rank];
+        const Part::Neighbor *back = nullptr;
+        for(const auto &m : other.neighbors()) {
+          if(m.rank == part.rank()) {
+            back = &m;
+          }
+        }
+        REQUIRE(back != nullptr);
+        REQUIRE(int(back->send.size()) == n.recv_count);
+        for(int i = 0; i < n.recv_count; i++) {
+          REQUIRE(other.global_index(back->send[i]) ==
+                  part.global_index(n.recv_offset + i));
+          REQUIRE(back->send[i] >= other.num_interior());
+          REQUIRE(back->send[i] < other.num_owned());
+        }
+      }
+    }
+    for(int owner_count : owners) {
+      REQUIRE(owner_count == 1);
+    }
+  }
+}
+
+TEST_CASE("Runge-Kutta Time Stepping",
+          "[TimeIntegration]") {
+  constexpr const int dim = 2;
+  constexpr const int degree = 2;
+  constexpr const int num_elems = 64;
+  using CoeffT = double;
+  using P = Polynomial<CoeffT, degree, dim>;
+  using RK = TimeIntegration::ExplicitRK<P>;
+
+  /* Each element decays at its own rate, du/dt = -k u, so
+   * the exact solution is u(0) exp(-k t) */
+  auto decay_rate = [](int e) { return 1.0 + e / 32.0; };
+  auto kernel = [&](double t, const RK::Block &U, int e,
+                    P &R, int thread) {
+    R = U[e] * -decay_rate(e);
+  };
+  auto initial = [](int e) {
+    P p;
+    p.coeff_iterator([&](const Array<int, dim> &exponents) {
+      p.coeff(exponents) =
+          1.0 + e + exponents[0] - 2.0 * exponents[1];
+    });
+    return p;
+  };
+  auto max_error = [&](TimeIntegration::Scheme scheme,
+                       int num_steps,
+                       Parallel::Scheduler *sched) {
+    RK rk(scheme,
+          TimeIntegration::element_rhs<P>(kernel, sched),
+          sched);
+    RK::Block U;
+    for(int e = 0; e < num_elems; e++) {
+      U.push_back(initial(e));
+    }
+    const double t_end = 1.0;
+    const double dt = t_end / num_steps;
+    for(int i = 0; i < num_steps; i++) {
+      rk.step(U, i * dt, dt);
+    }
+    REQUIRE(rk.timer().element_updates() ==
+            long(num_elems) * num_steps * rk.num_stages());
+    double err = 0.0;
+    for(int e = 0; e < num_elems; e++) {
+      const P expected = initial(e);
+      U[e].coeff_iterator(
+          [&](const Array<int, dim> &exponents) {
+            const double exact =
+                expected.coeff(exponents) *
+                std::exp(-decay_rate(e) * t_end);
+            err = std::max(err, std::abs(U[e].coeff(
+                                          exponents) -
+                                      exact));
+          });
+    }
+    return err;
+  };
+
+  Parallel::Scheduler sched(4);
+  SECTION("SSP-RK3 is third order") {
+    const double coarse =
+        max_error(TimeIntegration::Scheme::SSP_RK3, 20,
+                  nullptr);
+    const double fine = max_error(
+        TimeIntegration::Scheme::SSP_RK3, 40, &sched);
+    REQUIRE(std::log2(coarse / fine) ==
+            Approx(3.0).epsilon(0.1));
+  }
+  SECTION("LSRK(5,4) is fourth order") {
+    const double coarse = max_error(
+        TimeIntegration::Scheme::LSRK54, 10, nullptr);
+    const double fine = max_error(
+        TimeIntegration::Scheme::LSRK54, 20, &sched);
+    REQUIRE(std::log2(coarse / fine) ==
+            Approx(4.0).epsilon(0.1));
+  }
+}
+
+TEST_CASE("Lagrange Node Ordering", "[IO]") {
+  SECTION("Hexahedron") {
+    const auto nodes =
+        IO::lagrange_nodes<3>(IO::CellShape::Box, 2);
+    REQUIRE(nodes.size() == 27);
+    /* Vertices, then the first edge, the first k edge, the
+     * first face and the body */
+    REQUIRE((nodes[0] == Array<int, 3>(0, 0, 0)));
+    REQUIRE((nodes[2] == Array<int, 3>(2, 2, 0)));
+    REQUIRE((nodes[3] == Array<int, 3>(0, 2, 0)));
+    REQUIRE((nodes[6] == Array<int, 3>(2, 2, 2)));
+    REQUIRE((nodes[8] == Array<int, 3>(1, 0, 0)));
+    REQUIRE((nodes[11] == Array<int, 3>(0, 1, 0)));
+    REQUIRE((nodes[16] == Array<int, 3>(0, 0, 1)));
+    REQUIRE((nodes[18] == Array<int, 3>(0, 2, 1)));
+    REQUIRE((nodes[19] == Array<int, 3>(2, 2, 1)));
+    REQUIRE((nodes[20] == Array<int, 3>(0, 1, 1)));
+    REQUIRE((nodes[21] == Array<int, 3>(2, 1, 1)));
+    REQUIRE((nodes[24] == Array<int, 3>(1, 1, 0)));
+    REQUIRE((nodes[26] == Array<int, 3>(1, 1, 1)));
+  }
+  SECTION("Tetrahedron") {
+    for(int order = 1; order <= 6; order++) {
+      const auto nodes = IO::lagrange_nodes<3>(
+          IO::CellShape::Simplex, order);
+      REQUIRE(int(nodes.size()) ==
+              Utilities::poly_num_coeffs(order, 3));
+      /* Every lattice point appears once */
+      for(int i = 0; i < int(nodes.size()); i++) {
+        REQUIRE(CTMath::sum(nodes[i]) <= order);
+        for(int j = 0; j < i; j++) {
+          REQUIRE(!(nodes[i] == nodes[j]));
+        }
+      }
+    }
+    const auto nodes =
+        IO::lagrange_nodes<3>(IO::CellShape::Simplex, 3);
+    REQUIRE((nodes[3] == Array<int, 3>(0, 0, 3)));
+    REQUIRE((nodes[4] == Array<int, 3>(1, 0, 0)));
+    REQUIRE((nodes[6] == Array<int, 3>(2, 1, 0)));
+    REQUIRE((nodes[8] == Array<int, 3>(0, 2, 0)));
+    REQUIRE((nodes[10] == Array<int, 3>(0, 0, 1)));
+    REQUIRE((nodes[16] == Array<int, 3>(1, 0, 1)));
+    REQUIRE((nodes[17] == Array<int, 3>(1, 1, 1)));
+    REQUIRE((nodes[18] == Array<int, 3>(0, 1, 1)));
+    REQUIRE((nodes[19] == Array<int, 3>(1, 1, 0)));
+  }
+  SECTION("Triangle") {
+    const auto nodes =
+        IO::lagrange_nodes<2>(IO::CellShape::Simplex, 4);
+    REQUIRE(nodes.size() == 15);
+    REQUIRE((nodes[3] == Array<int, 2>(1, 0)));
+    REQUIRE((nodes[6] == Array<int, 2>(3, 1)));
+    REQUIRE((nodes[12] == Array<int, 2>(1, 1)));
+    REQUIRE((nodes[13] == Array<int, 2>(2, 1)));
+    REQUIRE((nodes[14] == Array<int, 2>(1, 2)));
+  }
+}
+
+TEST_CASE("VTU Writer", "[IO]") {
+  constexpr const int dim = 3;
+  constexpr const int degree = 2;
+  using CoeffT = double;
+  using P = Polynomial<CoeffT, degree, dim>;
+  using Writer = IO::VTUWriter<CoeffT, degree, dim>;
+  const std::string filename = "vtu_writer_test.vtu";
+
+  P p;
+  p.coeff_iterator([&](const Array<int, dim> &exponents) {
+    p.coeff(exponents) =
+        1.0 + exponents[0] + 2.0 * exponents[1] -
+        exponents[2];
+  });
+  Writer::Vertices verts;
+  verts[0] = Array<double, dim>(1.0, 2.0, 3.0);
+  verts[1] = Array<double, dim>(3.0, 2.0, 3.0);
+  verts[2] = Array<double, dim>(1.0, 3.0, 3.0);
+  verts[3] = Array<double, dim>(1.0, 2.0, 7.0);
+
+  auto read_file = [&]() {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+  };
+
+  SECTION("Raw") {
+    constexpr const int num_elems = 5;
+    {
+      /* Use a tiny chunk size to test multiple pieces */
+      Writer w(filename, IO::CellShape::Box, 2,
+               IO::VTUCompression::Raw, "u", 2);
+      for(int e = 0; e < num_elems; e++) {
+        w.write_element(verts, p * CoeffT(e));
+      }
+    }
+    const std::string vtu = read_file();
+    REQUIRE(vtu.find("<Piece NumberOfPoints=\"54\" "
+                     "NumberOfCells=\"2\">") !=
+            std::string::npos);
+    REQUIRE(vtu.find("<Piece NumberOfPoints=\"27\" "
+                     "NumberOfCells=\"1\">") !=
+            std::string::npos);
+    /* The first array of the first piece is the field */
+    const std::size_t start =
+        vtu.find("_", vtu.find("<AppendedData")) + 1;
+    std::uint64_t bytes;
+    std::memcpy(&bytes, &vtu[start], sizeof(bytes));
+    REQUIRE(bytes == 2 * 27 * sizeof(double));
+    const auto nodes =
+        IO::lagrange_nodes<dim>(IO::CellShape::Box, 2);
+    for(int e = 0; e < 2; e++) {
+      for(int n = 0; n < 27; n++) {
+        double v;
+        std::memcpy(&v,
+                    &vtu[start + sizeof(bytes) +
+                         (e * 27 + n) * sizeof(double)],
+                    sizeof(v));
+        REQUIRE(v == Approx(e * p.eval(nodes[n][0] / 2.0,
+                                       nodes[n][1] / 2.0,
+                                       nodes[n][2] / 2.0)));
+      }
+    }
+    std::remove(filename.c_str());
+  }
+
+  SECTION("ZLib") {
+    {
+      Writer w(filename, IO::CellShape::Simplex, 3,
+               IO::VTUCompression::ZLib);
+      w.write_element(verts, p);
+    }
+    const std::string vtu = read_file();
+    REQUIRE(vtu.find("vtkZLibDataCompressor") !=
+            std::string::npos);
+    REQUIRE(vtu.find("<Piece NumberOfPoints=\"20\" "
+                     "NumberOfCells=\"1\">") !=
+            std::string::npos);
+    const std::size_t start =
+        vtu.find("_", vtu.find("<AppendedData")) + 1;
+    std::uint64_t header[4];
+    std::memcpy(header, &vtu[start], sizeof(header));
+    REQUIRE(header[0] == 1);
+    REQUIRE(header[2] == 20 * sizeof(double));
+    std::vector<double> values(20);
+    uLongf len = uLongf(header[2]);
+    const int status = uncompress(
+        reinterpret_cast<Bytef *>(values.data()), &len,
+        reinterpret_cast<const Bytef *>(
+            &vtu[start + sizeof(header)]),
+        uLong(header[3]));
+    REQUIRE(status == Z_OK);
+    const auto nodes =
+        IO::lagrange_nodes<dim>(IO::CellShape::Simplex, 3);
+    for(int n = 0; n < 20; n++) {
+      REQUIRE(values[n] ==
+              Approx(p.eval(nodes[n][0] / 3.0,
+                            nodes[n][1] / 3.0,
+                            nodes[n][2] / 3.0)));
+    }
+    std::remove(filename.c_str());
+  }
+
+  SECTION("Errors") {
+    /* A directory can't be opened as the output file */
+    const std::string dir = ".";
+    const std::string side = dir + ".appended";
+    {
+      Writer w(dir, IO::CellShape::Box);
+      w.write_element(verts, p);
+      REQUIRE_THROWS_AS(w.close(), std::runtime_error);
+    }
+    REQUIRE(!std::ifstream(side.c_str()));
+    /* The destructor drops the error */
+    REQUIRE_NOTHROW([&]() {
+      Writer w(dir, IO::CellShape::Box);
+      w.write_element(verts, p);
+    }());
+    REQUIRE(!std::ifstream(side.c_str()));
+  }
+}
+
+TEST_CASE("Fraction Arithmetic", "[Fraction]") {
+  using Numerical::Fraction;
+  const Fraction half(1, 2);
+  const Fraction third(1, 3);
+  SECTION("Normalization") {
+    const Fraction f(6, -4);
+    REQUIRE(f.numerator() == -3);
+    REQUIRE(f.denominator() == 2);
+    REQUIRE(Fraction(0, -5) == Fraction(0));
+    REQUIRE(Fraction(0, -5).denominator() == 1);
+    REQUIRE(Fraction::gcd(48, 180) == 12);
+    REQUIRE(Fraction::gcd(0, 7) == 7);
+    REQUIRE(Fraction::gcd(17, 5) == 1);
+  }
+  SECTION("Operators") {
+    REQUIRE(half + third == Fraction(5, 6));
+    REQUIRE(half - third == Fraction(1, 6));
+    REQUIRE(half - half == Fraction(0));
+    REQUIRE(Fraction(2, 3) * Fraction(9, 4) ==
+            Fraction(3, 2));
+    REQUIRE(half / Fraction(-3, 4) == Fraction(-2, 3));
+    REQUIRE(1 - third == Fraction(2, 3));
+    REQUIRE(2 * third == Fraction(2, 3));
+    Fraction f = half;
+    f += third;
+    f *= 6;
+    REQUIRE(f == 5);
+    f /= 10;
+    REQUIRE(f == half);
+    REQUIRE(-f == Fraction(-1, 2));
+  }
+  SECTION("Comparisons") {
+    REQUIRE(third < half);
+    REQUIRE(half > third);
+    REQUIRE(-half < third);
+    REQUIRE(third <= third);
+    REQUIRE(half >= third);
+    REQUIRE(half != third);
+    REQUIRE(Fraction(INT64_MAX - 2, INT64_MAX - 1) <
+            Fraction(INT64_MAX - 1, INT64_MAX));
+  }
+  SECTION("Conversions") {
+    REQUIRE(double(Fraction(1, 4)) == 0.25);
+    REQUIRE(double(Fraction(-3, 8)) == -0.375);
+    std::stringstream ss;
+    ss << Fraction(-3, 8) << " " << Fraction(4, 2);
+    REQUIRE(ss.str() == "-3/8 2");
+  }
+  SECTION("Overflow") {
+    /* The cross products overflow 64 bits, but the reduced
+     * sum fits */
+    const Fraction big = Fraction(INT64_MAX, 6) +
+                         Fraction(-INT64_MAX, 10);
+    REQUIRE(big == Fraction(INT64_MAX, 15));
+    REQUIRE(Fraction(INT64_MAX, 2) *
+                Fraction(2, INT64_MAX) ==
+            1);
+    REQUIRE_THROWS_AS(Fraction(INT64_MAX) + 1,
+                      std::overflow_error);
+    REQUIRE_THROWS_AS(Fraction(1, INT64_MAX) * half,
+                      std::overflow_error);
+  }
+}
+
+TEST_CASE("Exact Polynomial", "[Polynomial][Fraction]") {
+  using Numerical::Fraction;
+  using P = Polynomial<Fraction, 2, 2>;
+  P p((Tags::Zero_Tag()));
+  p.coeff(2, 0) = 1;
+  p.coeff(1, 1) = Fraction(1, 3);
+  p.coeff(0, 0) = -1;
+  const auto integral = p.integrate(0).integrate(1);
+  REQUIRE(integral.eval(1, 1) - integral.eval(0, 0) ==
+          Fraction(-7, 12));
+  REQUIRE(p.eval(Fraction(1, 2), Fraction(3, 2)) ==
+          Fraction(-1, 2));
+  const Polynomial<double, 2, 2> rounded(p);
+  REQUIRE(rounded.coeff(1, 1) == 1.0 / 3.0);
+  REQUIRE(rounded.coeff(0, 0) == -1.0);
+}
+
+template <typename CoeffT, int degree>
+CoeffT unit_interval_dot(
+    const Polynomial<CoeffT, degree, 1> &p,
+    const Polynomial<CoeffT, degree, 1> &q) {
+  const auto integral = p.product(q).integrate(0);
+  return integral.eval(CoeffT(1)) -
+         integral.eval(CoeffT(0));
+}
+
+/* Runs classical Gram-Schmidt on the monomials over [0, 1]
+ * and returns the largest cosine between two of the
+ * resulting polynomials */
+template <typename CoeffT, int degree>
+double monomial_orthogonality() {
+  using P = Polynomial<CoeffT, degree, 1>;
+  std::vector<P> basis;
+  for(int k = 0; k <= degree; k++) {
+    P mono((Tags::Zero_Tag()));
+    mono.coeff(k) = CoeffT(1);
+    P q = mono;
+    for(const P &b : basis) {
+      const CoeffT scale = unit_interval_dot(mono, b) /
+                           unit_interval_dot(b, b);
+      q = q + -(b * scale);
+    }
+    basis.push_back(q);
+  }
+  double worst = 0.0;
+  for(int i = 0; i <= degree; i++) {
+    for(int j = 0; j < i; j++) {
+      const double cosine =
+          double(unit_interval_dot(basis[i], basis[j])) /
+          std::sqrt(double(unit_interval_dot(basis[i],
+                                             basis[i])) *
+                    double(unit_interval_dot(basis[j],
+                                             basis[j])));
+      worst = std::max(worst, std::abs(cosine));
+    }
+  }
+  return worst;
+}
+
+TEST_CASE("Double-Double Arithmetic", "[DoubleDouble]") {
+  using Numerical::DoubleDouble;
+  using Numerical::Fraction;
+  SECTION("Error-free sums and products") {
+    /* 1 + 2^-80 isn't representable in a double */
+    const DoubleDouble tiny(std::ldexp(1.0, -80));
+    const DoubleDouble sum = DoubleDouble(1.0) + tiny;
+    REQUIRE(sum.high() == 1.0);
+    REQUIRE(sum.low() == std::ldexp(1.0, -80));
+    REQUIRE(sum - 1.0 == tiny);
+    const double a = 1.0 + std::ldexp(1.0, -40);
+    const DoubleDouble sq = DoubleDouble(a) * a;
+    REQUIRE(sq.high() == a * a);
+    REQUIRE(sq.low() == std::ldexp(1.0, -80));
+    REQUIRE(DoubleDouble(INT64_MAX) - DoubleDouble(1) ==
+            DoubleDouble(INT64_MAX - 1));
+  }
+  SECTION("Division and square roots") {
+    const DoubleDouble third = DoubleDouble(1) / 3;
+    const DoubleDouble err = third * 3 - 1;
+    REQUIRE(std::abs(double(err)) < 1e-31);
+    REQUIRE(DoubleDouble(Fraction(1, 3)) == third);
+    const DoubleDouble root2 = sqrt(DoubleDouble(2));
+    REQUIRE(std::abs(double(root2 * root2 - 2)) < 1e-31);
+    REQUIRE(root2.high() == std::sqrt(2.0));
+    REQUIRE(third < root2);
+    REQUIRE(-root2 < third);
+    REQUIRE(abs(-root2) == root2);
+  }
+  SECTION("Polynomial coefficients") {
+    /* The Hilbert-like moment matrix makes Gram-Schmidt on
+     * the monomials lose orthogonality in double */
+    const double dd_cos =
+        monomial_orthogonality<DoubleDouble, 10>();
+    const double double_cos =
+        monomial_orthogonality<double, 10>();
+    REQUIRE(dd_cos < 1e-15);
+    REQUIRE(double_cos > 1e-3);
+  }
+}
+
+TEST_CASE("SIMD Coefficients", "[Polynomial][SIMD]") {
+  constexpr const int degree = 3;
+  constexpr const int dim = 3;
+  constexpr const int width = 4;
+  using SIMD = Numerical::simd<double, width>;
+  using ScalarP = Polynomial<double, degree, dim>;
+  using VectorP = Polynomial<SIMD, degree, dim>;
+  std::mt19937_64 rng(32);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  ScalarP lanes[width];
+  VectorP packed;
+  for(int k = 0; k < ScalarP::num_coeffs; k++) {
+    for(int l = 0; l < width; l++) {
+      lanes[l].data()[k] = pdf(rng);
+      packed.data()[k].set(l, lanes[l].data()[k]);
+    }
+  }
+  SECTION("One polynomial per lane") {
+    const double x = 0.3, y = -0.7, z = 1.1;
+    const SIMD v = packed.eval(x, y, z);
+    for(int l = 0; l < width; l++) {
+      REQUIRE(v[l] == Approx(lanes[l].eval(x, y, z)));
+    }
+    const auto integral = packed.integrate(1);
+    const auto product = packed * packed;
+    for(int l = 0; l < width; l++) {
+      REQUIRE(integral.eval(x, y, z)[l] ==
+              Approx(lanes[l].integrate(1).eval(x, y, z)));
+      REQUIRE(product.eval(x, y, z)[l] ==
+              Approx((lanes[l] * lanes[l]).eval(x, y, z)));
+    }
+  }
+  SECTION("One point per lane") {
+    /* Broadcasting one polynomial and giving each lane its
+     * own point evaluates it at four points at once */
+    const VectorP broadcast(lanes[0]);
+    SIMD x, y, z;
+    for(int l = 0; l < width; l++) {
+      x.set(l, pdf(rng));
+      y.set(l, pdf(rng));
+      z.set(l, pdf(rng));
+    }
+    const SIMD v = broadcast.eval(x, y, z);
+    for(int l = 0; l < width; l++) {
+      REQUIRE(v[l] ==
+              Approx(lanes[0].eval(x[l], y[l], z[l])));
+    }
+  }
+  SECTION("Traits") {
+    using Traits = Numerical::CoeffTraits<SIMD>;
+    REQUIRE(Traits::is_zero(Traits::zero()));
+    REQUIRE(Traits::one() == SIMD(1.0));
+    const SIMD f = Traits::fma(Traits::broadcast(2),
+                               SIMD(3.0), Traits::one());
+    for(int l = 0; l < width; l++) {
+      REQUIRE(f[l] == 7.0);
+    }
+    /* (1 + 2^-30) (1 - 2^-30) - 1 = -2^-60 is only kept if
+     * the multiply-add is rounded once */
+    const double e = std::ldexp(1.0, -30);
+    const SIMD fused = Traits::fma(
+        SIMD(1.0 + e), SIMD(1.0 - e), SIMD(-1.0));
+    for(int l = 0; l < width; l++) {
+      REQUIRE(fused[l] == -std::ldexp(1.0, -60));
+    }
+    REQUIRE(Numerical::CoeffTraits<double>::fma(
+                2.0, 3.0, 1.0) == 7.0);
+  }
+}
+
+TEST_CASE("Dual Numbers", "[Dual]") {
+  using Numerical::Dual;
+  SECTION("Derivatives") {
+    using D = Dual<double, 2>;
+    const D x = D::variable(3.0, 0);
+    const D y = D::variable(-2.0, 1);
+    /* f = x^2 y + x / y + 1 */
+    const D f = x * x * y + x / y + 1;
+    REQUIRE(f.value() == Approx(-18.0 - 1.5 + 1.0));
+    REQUIRE(f.derivative(0) ==
+            Approx(2 * 3.0 * -2.0 - 0.5));
+    REQUIRE(f.derivative(1) == Approx(9.0 - 3.0 / 4.0));
+    const D r = sqrt(x);
+    REQUIRE(r.derivative(0) ==
+            Approx(0.5 / std::sqrt(3.0)));
+    REQUIRE(r.derivative(1) == 0.0);
+  }
+  SECTION("Second derivatives") {
+    using D1 = Dual<double, 1>;
+    using D2 = Dual<D1, 1>;
+    const D2 x(D1::variable(2.0, 0),
+               Array<D1, 1>(D1(1.0)));
+    const D2 cube = x * x * x;
+    REQUIRE(cube.value().value() == 8.0);
+    REQUIRE(cube.derivative(0).value() == 12.0);
+    REQUIRE(cube.derivative(0).derivative(0) == 12.0);
+  }
+  SECTION("Polynomial Jacobian") {
+    /* r_i(u) = int_0^1 u(x)^2 x^i dx, with u's monomial
+     * coefficients as the degrees of freedom; the Jacobian
+     * is dr_i / du_j = int_0^1 2 u(x) x^(i + j) dx */
+    constexpr const int degree = 3;
+    constexpr const int ndofs = degree + 1;
+    auto residual = [](const auto &in, auto &out) {
+      using CoeffT =
+          typename std::decay<decltype(in[0])>::type;
+      Polynomial<CoeffT, degree, 1> u;
+      for(int j = 0; j < ndofs; j++) {
+        u.coeff(j) = in[j];
+      }
+      const auto u2 = u * u;
+      for(int i = 0; i < ndofs; i++) {
+        Polynomial<CoeffT, degree, 1> test(
+            (Tags::Zero_Tag()));
+        test.coeff(i) = CoeffT(1);
+        const auto integral = (u2 * test).integrate(0);
+        out[i] = integral.eval(1) - integral.eval(0);
+      }
+    };
+    const std::vector<double> u = {0.5, -1.0, 2.0, 0.25};
+    std::vector<double> J, r;
+    /* Two seed directions need two passes over the dofs */
+    Numerical::jacobian<2>(residual, u, ndofs, J, &r);
+    std::vector<double> expected_r(ndofs);
+    residual(u, expected_r);
+    for(int i = 0; i < ndofs; i++) {
+      REQUIRE(r[i] == Approx(expected_r[i]));
+      for(int j = 0; j < ndofs; j++) {
+        double expected = 0.0;
+        for(int k = 0; k < ndofs; k++) {
+          expected += 2.0 * u[k] / (i + j + k + 1);
+        }
+        REQUIRE(J[i * ndofs + j] == Approx(expected));
+      }
+    }
+  }
+}
+
+TEST_CASE("Binomial Coefficients", "[CTMath]") {
+  /* The old factorial ratios overflowed int for these */
+  static_assert(CTMath::n_choose_k<int>(30, 10) == 30045015,
+                "Binomial coefficients must be exact");
+  static_assert(Utilities::poly_num_coeffs<int>(16, 8) ==
+                    735471,
+                "Coefficient counts must be exact");
+  static_assert(CTMath::n_choose_k<long long>(66, 33) ==
+                    7219428434016265740LL,
+                "The table must cover 64 bit values");
+  static_assert(CTMath::n_choose_k<int>(3, 4) == 0,
+                "Out of range coefficients are zero");
+  static_assert(CTMath::partialFactorial<int>(1, 12) ==
+                    479001600,
+                "12! fits in an int");
+  REQUIRE(CTMath::n_choose_k<int>(5, -1) == 0);
+  REQUIRE(CTMath::n_choose_k<int>(7, 0) == 1);
+  REQUIRE(CTMath::n_choose_k<int>(7, 7) == 1);
+  REQUIRE_THROWS_AS(CTMath::n_choose_k<int>(34, 17),
+                    std::overflow_error);
+  REQUIRE_THROWS_AS(CTMath::n_choose_k<long long>(67, 33),
+                    std::overflow_error);
+  /* Runtime counts report the overflow rather than
+   * terminating */
+  REQUIRE_THROWS_AS(Utilities::poly_num_coeffs<int>(70, 3),
+                    std::overflow_error);
+  REQUIRE_THROWS_AS(
+      (DynamicPolynomial<double, 3>(70, Tags::Zero_Tag())),
+      std::overflow_error);
+  REQUIRE_THROWS_AS(CTMath::partialFactorial<int>(1, 13),
+                    std::overflow_error);
+  for(int n = 1; n < 40; n++) {
+    for(int k = 1; k < n; k++) {
+      REQUIRE(CTMath::n_choose_k<long long>(n, k) ==
+              CTMath::n_choose_k<long long>(n - 1, k - 1) +
+                  CTMath::n_choose_k<long long>(n - 1, k));
+    }
+  }
+  SECTION("High degree indexing") {
+    /* Every term of a degree 16, 8 variable polynomial
+     * gets its own slot, in term_exponents order */
+    constexpr const int degree = 16;
+    constexpr const int dim = 8;
+    using P = Polynomial<int, degree, dim>;
+    std::unique_ptr<P> p(new P((Tags::Zero_Tag())));
+    const auto terms =
+        Utilities::term_exponents<dim>(degree);
+    REQUIRE(int(terms.size()) == int(P::num_coeffs));
+    for(int i = 0; i < int(terms.size()); i++) {
+      p->coeff(terms[i]) += i + 1;
+    }
+    bool bijective = true;
+    for(int i = 0; i < int(P::num_coeffs); i++) {
+      bijective = bijective && (p->data()[i] == i + 1);
+    }
+    REQUIRE(bijective);
+  }
+}
+
+TEST_CASE("Array Layout", "[Array]") {
+  static_assert(std::is_trivially_copyable<
+                    Array<double, 5> >::value,
+                "Arrays of scalars must be trivially "
+                "copyable");
+  static_assert(std::is_trivially_copyable<
+                    Polynomial<double, 3, 3> >::value,
+                "Polynomials of scalars must be trivially "
+                "copyable");
+  static_assert(std::is_standard_layout<
+                    Array<float, 7> >::value,
+                "Arrays must be standard layout");
+  static_assert(alignof(Array<double, 4>) ==
+                    alignof(double),
+                "Arrays are only aligned to T by default");
+  static_assert(alignof(Array<double, 4, 32>) == 32,
+                "Arrays can be over-aligned");
+  static_assert(sizeof(Array<double, 5, 64>) == 64,
+                "Over-aligned Arrays are padded");
+  constexpr Array<int, 3> ce(1, 2, 3);
+  constexpr Array<int, 3> ce_zero((Tags::Zero_Tag()));
+  static_assert(ce[2] == 3 && ce_zero[1] == 0,
+                "Arrays can be constant expressions");
+  static_assert(CTMath::sum(ce) == 6,
+                "Arrays can be constant expressions");
+
+  Array<double, 4, 32> a = {1.0, 2.0, 3.0, 4.0};
+  REQUIRE(reinterpret_cast<std::uintptr_t>(&a) % 32 == 0);
+  Array<double, 4, 32> b;
+  Array<double, 4, 32> &ref = (b = a);
+  REQUIRE(&ref == &b);
+  REQUIRE(b == a);
+  b[3] = 5.0;
+  REQUIRE(b != a);
+  const Array<double, 4, 32> moved(std::move(b));
+  REQUIRE(moved[3] == 5.0);
+}
+
+TEST_CASE("Dynamic Polynomial", "[Polynomial]") {
+  constexpr const int dim = 3;
+  using Fixed2 = Polynomial<double, 2, dim>;
+  using Fixed3 = Polynomial<double, 3, dim>;
+  using Dynamic = DynamicPolynomial<double, dim>;
+  std::mt19937_64 rng(37);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  Fixed2 f2;
+  Fixed3 f3;
+  for(int i = 0; i < Fixed2::num_coeffs; i++) {
+    f2.data()[i] = pdf(rng);
+  }
+  for(int i = 0; i < Fixed3::num_coeffs; i++) {
+    f3.data()[i] = pdf(rng);
+  }
+  CoefficientPool<double> pool(8);
+  const Dynamic d2(f2, &pool);
+  const Dynamic d3(f3, &pool);
+  REQUIRE(d2.degree() == 2);
+  REQUIRE(d3.num_coeffs() == int(Fixed3::num_coeffs));
+  const double x = 0.3, y = -0.6, z = 0.8;
+
+  SECTION("Conversions") {
+    REQUIRE(d2.coeff(1, 0, 1) == f2.coeff(1, 0, 1));
+    REQUIRE(d2.eval(x, y, z) == Approx(f2.eval(x, y, z)));
+    const Fixed3 back = d2.to_fixed<3>();
+    REQUIRE(back.coeff(0, 2, 0) == f2.coeff(0, 2, 0));
+    REQUIRE(back.coeff(1, 1, 1) == 0.0);
+    REQUIRE(std::memcmp(d3.to_fixed<3>().data(), f3.data(),
+                        sizeof(Fixed3)) == 0);
+  }
+  SECTION("Arithmetic") {
+    const Dynamic sum = d2 + d3;
+    const Dynamic prod = d2 * d3;
+    REQUIRE(sum.degree() == 3);
+    REQUIRE(prod.degree() == 5);
+    REQUIRE(sum.eval(x, y, z) ==
+            Approx((f3 + f2).eval(x, y, z)));
+    REQUIRE(prod.eval(x, y, z) ==
+            Approx(f2.product(f3).eval(x, y, z)));
+    const double diff = f3.eval(x, y, z) - f2.eval(x, y, z);
+    REQUIRE((d3 - d2 + 2.0).eval(x, y, z) ==
+            Approx(diff + 2.0));
+    REQUIRE((3.0 * d2).eval(x, y, z) ==
+            Approx(3.0 * f2.eval(x, y, z)));
+  }
+  SECTION("Calculus") {
+    for(int v = 0; v < dim; v++) {
+      REQUIRE(d3.integrate(v, 1.5).eval(x, y, z) ==
+              Approx(f3.integrate(v, 1.5).eval(x, y, z)));
+      REQUIRE(d3.differentiate(v).eval(x, y, z) ==
+              Approx(f3.differentiate(v).eval(x, y, z)));
+      const DynamicPolynomial<double, dim - 1> s =
+          d3.slice(v, 0.25);
+      const auto fs = f3.slice(v, 0.25);
+      REQUIRE(s.eval(x, z) == Approx(fs.eval(x, z)));
+    }
+    const DynamicPolynomial<double, 1> line(
+        Polynomial<double, 2, 1>(Tags::Zero_Tag()) + 2.0);
+    REQUIRE(line.slice(0, 5.0).eval() == 2.0);
+    REQUIRE(line.differentiate(0).degree() == 1);
+  }
+  SECTION("Degree changes") {
+    Dynamic p = d2;
+    p.set_degree(4);
+    REQUIRE(p.num_coeffs() ==
+            Utilities::poly_num_coeffs(4, dim));
+    REQUIRE(p.coeff(2, 0, 0) == f2.coeff(2, 0, 0));
+    REQUIRE(p.coeff(0, 4, 0) == 0.0);
+    REQUIRE(p.eval(x, y, z) == Approx(f2.eval(x, y, z)));
+    p.set_degree(1);
+    REQUIRE(p.coeff(0, 1, 0) == f2.coeff(0, 1, 0));
+  }
+  SECTION("Moved from") {
+    Dynamic a(3, Tags::Zero_Tag());
+    Dynamic b(std::move(a));
+    REQUIRE(b.num_coeffs() ==
+            Utilities::poly_num_coeffs(3, dim));
+    REQUIRE(a.degree() == 0);
+    REQUIRE(a.num_coeffs() == 0);
+    Dynamic c(a);
+    REQUIRE(c.num_coeffs() == 0);
+    REQUIRE(c.data() == nullptr);
+    c = d2;
+    REQUIRE(c.eval(x, y, z) == Approx(f2.eval(x, y, z)));
+    c = a;
+    REQUIRE(c.num_coeffs() == 0);
+    a.set_degree(2);
+    REQUIRE(a.num_coeffs() ==
+            Utilities::poly_num_coeffs(2, dim));
+    REQUIRE(a.coeff(1, 1, 0) == 0.0);
+  }
+  SECTION("Pooling") {
+    /* Freed blocks are reused, so repeated arithmetic stops
+     * growing the pool */
+    Dynamic acc(d3);
+    for(int i = 0; i < 4; i++) {
+      acc = acc + d3 * 0.5;
+    }
+    const std::size_t reserved = pool.bytes_reserved();
+    for(int i = 0; i < 100; i++) {
+      acc = acc + d3 * 0.5;
+    }
+    REQUIRE(pool.bytes_reserved() == reserved);
+    REQUIRE(acc.eval(x, y, z) ==
+            Approx(53.0 * f3.eval(x, y, z)));
+    REQUIRE(acc.allocator() == &pool);
+  }
+}
+
+TEST_CASE("Polynomial Batch", "[Polynomial]") {
+  constexpr const int dim = 3;
+  constexpr const int count = 37;
+  using Poly = Polynomial<double, 2, dim>;
+  using Batch = PolynomialBatch<double, 2, dim>;
+  std::mt19937_64 rng(38);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  std::vector<Poly> polys(count), others(count);
+  Batch batch(count), other(count);
+  for(int i = 0; i < count; i++) {
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      polys[i].data()[k] = pdf(rng);
+      others[i].data()[k] = pdf(rng);
+    }
+    batch[i].set(polys[i]);
+    other[i] = others[i];
+  }
+  Polynomial<double, 1, dim> m;
+  for(int k = 0; k < decltype(m)::num_coeffs; k++) {
+    m.data()[k] = pdf(rng);
+  }
+  const Array<double, dim> pt(0.4, -0.3, 0.7);
+  const double x = pt[0], y = pt[1], z = pt[2];
+
+  SECTION("Views") {
+    const Batch &cbatch = batch;
+    REQUIRE(batch[3].coeff(1, 0, 1) ==
+            polys[3].coeff(1, 0, 1));
+    batch[3].coeff(0, 2, 0) = 5.0;
+    REQUIRE(cbatch[3].get().coeff(0, 2, 0) == 5.0);
+    REQUIRE(cbatch[4].eval(x, y, z) ==
+            Approx(polys[4].eval(x, y, z)));
+    const Poly p = cbatch[5];
+    REQUIRE(std::memcmp(p.data(), polys[5].data(),
+                        sizeof(Poly)) == 0);
+  }
+  SECTION("Kernels") {
+    std::vector<double> factors(count);
+    for(int i = 0; i < count; i++) {
+      factors[i] = pdf(rng);
+    }
+    const Batch sum = batch + other;
+    const Batch diff = batch - other;
+    const Batch scaled = 2.0 * batch;
+    const Batch each = batch.scale(factors.data());
+    const auto prod = batch.product(m);
+    const auto integral = batch.integrate(1);
+    const auto derivative = batch.differentiate(2);
+    std::vector<double> values(count);
+    batch.eval(pt, values.data());
+    for(int i = 0; i < count; i++) {
+      const Poly &p = polys[i];
+      REQUIRE(sum[i].eval(x, y, z) ==
+              Approx((p + others[i]).eval(x, y, z)));
+      REQUIRE(diff[i].eval(x, y, z) ==
+              Approx(p.eval(x, y, z) -
+                     others[i].eval(x, y, z)));
+      REQUIRE(scaled[i].eval(x, y, z) ==
+              Approx(2.0 * p.eval(x, y, z)));
+      REQUIRE(each[i].eval(x, y, z) ==
+              Approx(factors[i] * p.eval(x, y, z)));
+      REQUIRE(prod[i].eval(x, y, z) ==
+              Approx(p.product(m).eval(x, y, z)));
+      REQUIRE(integral[i].eval(x, y, z) ==
+              Approx(p.integrate(1).eval(x, y, z)));
+      REQUIRE(derivative[i].eval(x, y, z) ==
+              Approx(p.differentiate(2).eval(x, y, z)));
+      REQUIRE(values[i] == Approx(p.eval(x, y, z)));
+    }
+    const PolynomialBatch<double, 0, dim> constant(
+        count, Tags::Zero_Tag());
+    REQUIRE(constant.differentiate(0)[0].coeff(0, 0, 0) ==
+            0.0);
+  }
+}
+
+TEST_CASE("Sparse Polynomial", "[Polynomial]") {
+  constexpr const int dim = 6;
+  using Dense = Polynomial<double, 3, dim>;
+  using Sparse = SparsePolynomial<double, dim>;
+  std::mt19937_64 rng(39);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  std::uniform_int_distribution<int> which(0, 3);
+  /* Roughly a quarter of the coefficients are nonzero */
+  Dense p((Tags::Zero_Tag())), q((Tags::Zero_Tag()));
+  for(int k = 0; k < Dense::num_coeffs; k++) {
+    if(which(rng) == 0) {
+      p.data()[k] = pdf(rng);
+    }
+    if(which(rng) == 0) {
+      q.data()[k] = pdf(rng);
+    }
+  }
+  const Sparse sp(p), sq(q);
+  const Array<double, dim> pt(0.3, -0.5, 0.9, 0.1, -0.7,
+                             0.4);
+  auto dense_eval = [&](const auto &d) {
+    return d.eval(pt[0], pt[1], pt[2], pt[3], pt[4], pt[5]);
+  };
+
+  SECTION("Keys") {
+    const Array<int, dim> e(1, 0, 3, 0, 2, 5);
+    REQUIRE(Sparse::unpack(Sparse::pack(e)) == e);
+    REQUIRE(Sparse::key_degree(Sparse::pack(e)) == 11);
+    const Array<int, dim> f(0, 2, 1, 0, 0, 1);
+    const Array<int, dim> ef(1, 2, 4, 0, 2, 6);
+    REQUIRE(Sparse::pack(e) + Sparse::pack(f) ==
+            Sparse::pack(ef));
+  }
+  SECTION("Conversions") {
+    int nonzero = 0;
+    for(int k = 0; k < Dense::num_coeffs; k++) {
+      nonzero += p.data()[k] != 0.0;
+    }
+    REQUIRE(sp.num_terms() == nonzero);
+    REQUIRE(sp.degree() <= 3);
+    const Dense back = sp.to_dense<3>();
+    REQUIRE(std::memcmp(back.data(), p.data(),
+                        sizeof(Dense)) == 0);
+    REQUIRE(sp.eval(pt) == Approx(dense_eval(p)));
+    for(int i = 0; i < dim; i++) {
+      Array<int, dim> e((Tags::Zero_Tag()));
+      e[i] = 1;
+      REQUIRE(sp.coeff(e) == p.coeff(e));
+    }
+  }
+  SECTION("Arithmetic") {
+    REQUIRE((sp + sq).eval(pt) ==
+            Approx(dense_eval(p + q)));
+    REQUIRE((sp - sq).eval(pt) ==
+            Approx(dense_eval(p) - dense_eval(q)));
+    REQUIRE((sp - sp).num_terms() == 0);
+    REQUIRE((2.0 * sp + 1.0).eval(pt) ==
+            Approx(2.0 * dense_eval(p) + 1.0));
+    const Sparse prod = sp * sq;
+    const auto dense_prod = p.product(q);
+    /* The products are summed in a different order */
+    const Sparse expected(dense_prod);
+    REQUIRE(prod.num_terms() == expected.num_terms());
+    for(const auto &t : expected) {
+      REQUIRE(prod.coeff(Sparse::unpack(t.key)) ==
+              Approx(t.coeff));
+    }
+    REQUIRE(prod.eval(pt) ==
+            Approx(dense_eval(dense_prod)));
+  }
+  SECTION("Calculus") {
+    for(int v = 0; v < dim; v++) {
+      REQUIRE(sp.integrate(v, 2.0) ==
+              Sparse(p.integrate(v, 2.0)));
+      REQUIRE(sp.differentiate(v) ==
+              Sparse(p.differentiate(v)));
+    }
+  }
+  SECTION("Terms") {
+    Sparse s;
+    const Array<int, dim> e(0, 0, 2, 0, 0, 1);
+    s.add_term(e, 3.0);
+    s.add_term(Array<int, dim>(Tags::Zero_Tag()), 1.0);
+    REQUIRE(s.num_terms() == 2);
+    REQUIRE(s.degree() == 3);
+    REQUIRE(s.begin()->key == 0);
+    s.add_term(e, -3.0);
+    REQUIRE(s.num_terms() == 1);
+    REQUIRE(s.degree() == 0);
+  }
+}
+
+TEST_CASE("Affine Composition", "[Polynomial]") {
+  constexpr const int dim = 3;
+  constexpr const int degree = 4;
+  using Poly = Polynomial<double, degree, dim>;
+  using Map = AffineMap<double, degree, dim>;
+  std::mt19937_64 rng(40);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  Map::Matrix A;
+  Array<double, dim> b;
+  for(int i = 0; i < dim; i++) {
+    for(int j = 0; j < dim; j++) {
+      A[i][j] = pdf(rng);
+    }
+    b[i] = pdf(rng);
+  }
+  const Map map(A, b);
+  auto mapped = [&](const Poly &p,
+                    const Array<double, dim> &x) {
+    Array<double, dim> y;
+    for(int i = 0; i < dim; i++) {
+      y[i] = b[i];
+      for(int j = 0; j < dim; j++) {
+        y[i] += A[i][j] * x[j];
+      }
+    }
+    return p.eval(y[0], y[1], y[2]);
+  };
+  constexpr const int count = 9;
+  std::vector<Poly> polys(count);
+  PolynomialBatch<double, degree, dim> batch(count);
+  for(int i = 0; i < count; i++) {
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      polys[i].data()[k] = pdf(rng);
+    }
+    batch[i] = polys[i];
+  }
+  std::vector<Poly> composed(count);
+  map.compose(polys.data(), count, composed.data());
+  const auto composed_batch = map.compose(batch);
+  for(int t = 0; t < 10; t++) {
+    Array<double, dim> x;
+    for(int i = 0; i < dim; i++) {
+      x[i] = pdf(rng);
+    }
+    for(int i = 0; i < count; i++) {
+      const double expected = mapped(polys[i], x);
+      REQUIRE(composed[i].eval(x[0], x[1], x[2]) ==
+              Approx(expected));
+      REQUIRE(composed_batch[i].eval(x[0], x[1], x[2]) ==
+              Approx(expected));
+    }
+  }
+  /* The identity map leaves polynomials unchanged */
+  Map::Matrix I;
+  for(int i = 0; i < dim; i++) {
+    for(int j = 0; j < dim; j++) {
+      I[i][j] = i == j ? 1.0 : 0.0;
+    }
+  }
+  const Poly same = affine_compose(
+      polys[0], I, Array<double, dim>(Tags::Zero_Tag()));
+  for(int k = 0; k < Poly::num_coeffs; k++) {
+    REQUIRE(same.data()[k] == polys[0].data()[k]);
+  }
+  /* Translating x^2 by 1 gives x^2 + 2x + 1 */
+  Poly sq((Tags::Zero_Tag()));
+  sq.coeff(2, 0, 0) = 1.0;
+  const Poly shifted = affine_compose(
+      sq, I, Array<double, dim>(1.0, 0.0, 0.0));
+  REQUIRE(shifted.coeff(2, 0, 0) == 1.0);
+  REQUIRE(shifted.coeff(1, 0, 0) == 2.0);
+  REQUIRE(shifted.coeff(0, 0, 0) == 1.0);
+  REQUIRE(shifted.coeff(1, 1, 0) == 0.0);
+}
+
+TEST_CASE("Definite Integrals", "[Polynomial]") {
+  constexpr const int dim = 3;
+  constexpr const int degree = 4;
+  using Poly = Polynomial<double, degree, dim>;
+  std::mt19937_64 rng(41);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  Poly p;
+  for(int k = 0; k < Poly::num_coeffs; k++) {
+    p.data()[k] = pdf(rng);
+  }
+  Array<double, dim> lo, hi;
+  for(int d = 0; d < dim; d++) {
+    lo[d] = pdf(rng);
+    hi[d] = lo[d] + 0.75 + 0.25 * pdf(rng);
+  }
+
+  SECTION("Box") {
+    const auto antiderivative =
+        p.integrate(0).integrate(1).integrate(2);
+    /* Inclusion-exclusion over the corners */
+    double expected = 0.0;
+    for(int corner = 0; corner < (1 << dim); corner++) {
+      Array<double, dim> x;
+      int sign = 1;
+      for(int d = 0; d < dim; d++) {
+        if(corner & (1 << d)) {
+          x[d] = hi[d];
+        } else {
+          x[d] = lo[d];
+          sign = -sign;
+        }
+      }
+      expected +=
+          sign * antiderivative.eval(x[0], x[1], x[2]);
+    }
+    REQUIRE(integrate_box(p, lo, hi) == Approx(expected));
+    /* Exactly, for rational coefficients */
+    Polynomial<Fraction, 2, dim> q((Tags::Zero_Tag()));
+    q.coeff(2, 0, 0) = 1;
+    q.coeff(0, 1, 1) = Fraction(3, 2);
+    q.coeff(0, 0, 0) = -1;
+    const Array<Fraction, dim> zero((Tags::Zero_Tag()));
+    const Array<Fraction, dim> one(1, 1, 1);
+    /* 1/3 + 3/8 - 1 */
+    REQUIRE(integrate_box(q, zero, one) ==
+            Fraction(-7, 24));
+  }
+  SECTION("Simplex") {
+    /* The box is the union of the simplices of its Kuhn
+     * triangulation, one for each ordering of the axes */
+    Array<int, dim> order(0, 1, 2);
+    double total = 0.0;
+    do {
+      Array<Array<double, dim>, dim + 1> vertices;
+      vertices[0] = lo;
+      for(int k = 0; k < dim; k++) {
+        vertices[k + 1] = vertices[k];
+        vertices[k + 1][order[k]] = hi[order[k]];
+      }
+      total += integrate_simplex(p, vertices);
+    } while(std::next_permutation(order.data,
+                                  order.data + dim));
+    REQUIRE(total == Approx(integrate_box(p, lo, hi)));
+
+    /* The integral of x^a over the reference simplex is
+     * a! / (|a| + dim)! */
+    Array<Array<Fraction, dim>, dim + 1> reference;
+    for(int k = 0; k <= dim; k++) {
+      for(int d = 0; d < dim; d++) {
+        reference[k][d] = (k == d + 1) ? 1 : 0;
+      }
+    }
+    const SimplexMoments<Fraction, 4, dim> moments(
+        reference);
+    const Array<int, dim> e(2, 1, 1);
+    REQUIRE(moments.moment(Utilities::term_index(e)) ==
+            Fraction(2, 5040));
+    REQUIRE(moments.moment(0) == Fraction(1, 6));
+  }
+}
+
+TEST_CASE("Face Traces", "[Polynomial]") {
+  constexpr const int dim = 3;
+  constexpr const int degree = 3;
+  using Poly = Polynomial<double, degree, dim>;
+  using FacePoly = Polynomial<double, degree, dim - 1>;
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  constexpr const int count = 11;
+  std::vector<Poly> polys(count);
+  PolynomialBatch<double, degree, dim> batch(count);
+  for(int i = 0; i < count; i++) {
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      polys[i].data()[k] = pdf(rng);
+    }
+    batch[i] = polys[i];
+  }
+
+  SECTION("Cube") {
+    using Traces =
+        std::vector<FaceTrace<double, degree, dim> >;
+    const Traces &faces =
+        cube_face_traces<double, degree, dim>();
+    const Traces &cached =
+        cube_face_traces<double, degree, dim>();
+    REQUIRE(faces.size() == 2 * dim);
+    REQUIRE(&faces == &cached);
+    std::vector<PolynomialBatch<double, degree, dim - 1> >
+        traces;
+    face_traces(faces, batch, traces);
+    for(int d = 0; d < dim; d++) {
+      for(int s = 0; s < 2; s++) {
+        for(int i = 0; i < count; i++) {
+          const FacePoly expected = polys[i].slice(d, s);
+          const FacePoly trace =
+              faces[2 * d + s].compose(polys[i]);
+          const FacePoly batched = traces[2 * d + s][i];
+          for(int k = 0; k < FacePoly::num_coeffs; k++) {
+            REQUIRE(trace.data()[k] ==
+                    Approx(expected.data()[k]));
+            REQUIRE(batched.data()[k] ==
+                    Approx(expected.data()[k]));
+          }
+        }
+      }
+    }
+  }
+  SECTION("Simplex") {
+    const auto &faces =
+        simplex_face_traces<double, degree, dim>();
+    REQUIRE(faces.size() == dim + 1);
+    std::vector<PolynomialBatch<double, degree, dim - 1> >
+        traces;
+    face_traces(faces, batch, traces);
+    /* The face opposite the origin has the vertices
+     * e_0, e_1, e_2 */
+    const double s = 0.2, t = 0.3;
+    const Array<double, dim> x(1.0 - s - t, s, t);
+    for(int i = 0; i < count; i++) {
+      const double expected =
+          polys[i].eval(x[0], x[1], x[2]);
+      REQUIRE(faces[0].compose(polys[i]).eval(s, t) ==
+              Approx(expected));
+      REQUIRE(traces[0][i].eval(s, t) == Approx(expected));
+      /* The face opposite e_0 is x_0 = 0 */
+      REQUIRE(traces[1][i].eval(s, t) ==
+              Approx(polys[i].eval(0.0, s, t)));
+    }
+  }
+}
+
+TEST_CASE("Bernstein Polynomials", "[Polynomial]") {
+  constexpr const int dim = 3;
+  constexpr const int degree = 4;
+  using Poly = Polynomial<double, degree, dim>;
+  using Bernstein =
+      BernsteinPolynomial<double, degree, dim>;
+  std::mt19937_64 rng(43);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  Poly p;
+  for(int k = 0; k < Poly::num_coeffs; k++) {
+    p.data()[k] = pdf(rng);
+  }
+  const Bernstein b(p);
+  REQUIRE(int(Bernstein::num_coeffs) == 125);
+
+  SECTION("Conversion and evaluation") {
+    const Poly back = b.to_monomial();
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      REQUIRE(std::abs(back.data()[k] - p.data()[k]) <
+              1e-12);
+    }
+    const std::pair<double, double> bounds = b.bounds();
+    for(int t = 0; t < 20; t++) {
+      Array<double, dim> x;
+      for(int d = 0; d < dim; d++) {
+        x[d] = unit(rng);
+      }
+      const double v = b.eval(x);
+      REQUIRE(v == Approx(p.eval(x[0], x[1], x[2])));
+      /* The convex hull property */
+      REQUIRE(v >= bounds.first);
+      REQUIRE(v <= bounds.second);
+    }
+    /* Bernstein polynomials interpolate at the corners */
+    REQUIRE(b.eval(1.0, 0.0, 1.0) ==
+            b.coeff(degree, 0, degree));
+  }
+  SECTION("Degree changes") {
+    const BernsteinPolynomial<double, degree + 2, dim>
+        raised = b.change_degree<degree + 2>();
+    const Bernstein lowered =
+        raised.change_degree<degree>();
+    for(int i = 0; i < Bernstein::num_coeffs; i++) {
+      REQUIRE(std::abs(lowered.data()[i] - b.data()[i]) <
+              1e-12);
+    }
+    REQUIRE(raised.eval(0.3, 0.6, 0.2) ==
+            Approx(b.eval(0.3, 0.6, 0.2)));
+    /* Elevation tightens the bounds */
+    REQUIRE(raised.bounds().first >= b.bounds().first);
+    REQUIRE(raised.bounds().second <= b.bounds().second);
+  }
+  SECTION("Exact bounds") {
+    /* (x - 1/2)^2 + y z is in [0, 5/4] on the unit cube,
+     * the coefficients bound it by [-1/4, 5/4] */
+    Polynomial<Fraction, 2, dim> q((Tags::Zero_Tag()));
+    q.coeff(2, 0, 0) = 1;
+    q.coeff(1, 0, 0) = -1;
+    q.coeff(0, 0, 0) = Fraction(1, 4);
+    q.coeff(0, 1, 1) = 1;
+    const BernsteinPolynomial<Fraction, 2, dim> bq(q);
+    REQUIRE(bq.bounds().first == Fraction(-1, 4));
+    REQUIRE(bq.bounds().second == Fraction(5, 4));
+    REQUIRE(bq.coeff(1, 0, 0) == Fraction(-1, 4));
+    const Polynomial<Fraction, 2, dim> back =
+        bq.to_monomial();
+    REQUIRE(back.coeff(0, 1, 1) == Fraction(1));
+    REQUIRE(back.coeff(1, 0, 0) == Fraction(-1));
+  }
+}
+
+template <template <typename> class Family>
+void check_orthogonal_family() {
+  constexpr const int dim = 3;
+  constexpr const int degree = 5;
+  using Poly = Polynomial<double, degree, dim>;
+  using Ortho =
+      OrthogonalPolynomial<double, degree, dim, Family>;
+  std::mt19937_64 rng(44);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  Poly p;
+  for(int k = 0; k < Poly::num_coeffs; k++) {
+    p.data()[k] = pdf(rng);
+  }
+  const Ortho o(p);
+  const Poly back = o.to_monomial();
+  for(int k = 0; k < Poly::num_coeffs; k++) {
+    REQUIRE(std::abs(back.data()[k] - p.data()[k]) < 1e-12);
+  }
+  for(int t = 0; t < 10; t++) {
+    Array<double, dim> x;
+    for(int d = 0; d < dim; d++) {
+      x[d] = pdf(rng);
+    }
+    auto monomial_eval = [&](const auto &m) {
+      return m.eval(x[0], x[1], x[2]);
+    };
+    REQUIRE(o.eval(x) == Approx(monomial_eval(p)));
+    for(int v = 0; v < dim; v++) {
+      REQUIRE(o.differentiate(v).eval(x) ==
+              Approx(monomial_eval(p.differentiate(v))));
+      REQUIRE(o.integrate(v, 0.5).eval(x) ==
+              Approx(monomial_eval(p.integrate(v, 0.5))));
+    }
+  }
+}
+
+TEST_CASE("Orthogonal Polynomials", "[Polynomial]") {
+  SECTION("Chebyshev") {
+    check_orthogonal_family<Chebyshev>();
+    /* T_3 = 4 x^3 - 3 x */
+    ChebyshevPolynomial<Fraction, 3, 2> t3(
+        (Tags::Zero_Tag()));
+    t3.coeff(3, 0) = 1;
+    const Polynomial<Fraction, 3, 2> m = t3.to_monomial();
+    REQUIRE(m.coeff(3, 0) == Fraction(4));
+    REQUIRE(m.coeff(1, 0) == Fraction(-3));
+    REQUIRE(m.coeff(0, 0) == Fraction(0));
+    REQUIRE(t3.eval(Fraction(1, 2), Fraction(7)) ==
+            Fraction(-1));
+    /* T_3' = 3 U_2 = 6 T_2 + 3 T_0 */
+    const auto dt3 = t3.differentiate(0);
+    REQUIRE(dt3.coeff(2, 0) == Fraction(6));
+    REQUIRE(dt3.coeff(0, 0) == Fraction(3));
+    REQUIRE(dt3.coeff(1, 0) == Fraction(0));
+  }
+  SECTION("Legendre") {
+    check_orthogonal_family<Legendre>();
+    /* x^2 = (2 P_2 + P_0) / 3 */
+    Polynomial<Fraction, 2, 1> sq((Tags::Zero_Tag()));
+    sq.coeff(2) = 1;
+    const LegendrePolynomial<Fraction, 2, 1> l(sq);
+    REQUIRE(l.coeff(2) == Fraction(2, 3));
+    REQUIRE(l.coeff(1) == Fraction(0));
+    REQUIRE(l.coeff(0) == Fraction(1, 3));
+  }
+}
+
+TEST_CASE("Least Squares Fit", "[Polynomial]") {
+  constexpr const int dim = 2;
+  constexpr const int degree = 3;
+  using Poly = Polynomial<double, degree, dim>;
+  std::mt19937_64 rng(45);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  auto random_points = [&](int count) {
+    std::vector<Array<double, dim> > points(count);
+    for(auto &pt : points) {
+      pt[0] = pdf(rng);
+      pt[1] = pdf(rng);
+    }
+    return points;
+  };
+  Poly p;
+  for(int k = 0; k < Poly::num_coeffs; k++) {
+    p.data()[k] = pdf(rng);
+  }
+  const std::vector<Array<double, dim> > points =
+      random_points(40);
+  std::vector<double> values(points.size());
+  for(int i = 0; i < int(points.size()); i++) {
+    values[i] = p.eval(points[i][0], points[i][1]);
+  }
+  const std::vector<Array<double, dim> > few(
+      points.begin(), points.begin() + 5);
+  SECTION("Exact") {
+    Poly fit((Tags::Zero_Tag()));
+    REQUIRE(least_squares_fit(points, values.data(), fit));
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      REQUIRE(fit.data()[k] == Approx(p.data()[k]));
+    }
+    /* Too few samples to determine the fit */
+    REQUIRE(!least_squares_fit(few, values.data(), fit));
+    /* Points on the line y = 3 x only determine p up to
+     * multiples of y - 3 x; rounding makes R's last
+     * diagonal tiny rather than zero */
+    std::vector<Array<double, dim> > line(10);
+    std::vector<double> line_values(line.size());
+    for(int i = 0; i < int(line.size()); i++) {
+      line[i][0] = 0.1 * i;
+      line[i][1] = 0.3 * i;
+      line_values[i] = 1.0 + line[i][0];
+    }
+    Polynomial<double, 1, dim> linear((Tags::Zero_Tag()));
+    REQUIRE(!least_squares_fit(line, line_values.data(),
+                               linear));
+    REQUIRE(linear.data()[0] == 0.0);
+  }
+  SECTION("Weighted") {
+    /* Corrupt half of the samples, with no weight */
+    std::vector<double> noisy(values);
+    std::vector<double> weights(values.size());
+    for(int i = 0; i < int(values.size()); i++) {
+      weights[i] = i % 2 == 0 ? 1.0 + pdf(rng) * 0.5 : 0.0;
+      if(i % 2 == 1) {
+        noisy[i] += 10.0 * pdf(rng);
+      }
+    }
+    Poly fit;
+    REQUIRE(least_squares_fit(points, noisy.data(), fit,
+                              weights.data()));
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      REQUIRE(fit.data()[k] == Approx(p.data()[k]));
+    }
+  }
+  SECTION("Ridge") {
+    Poly fit;
+    Poly ridged;
+    REQUIRE(least_squares_fit(points, values.data(), fit));
+    REQUIRE(least_squares_fit(points, values.data(),
+                              ridged, nullptr, 1.0));
+    double fit_norm = 0.0, ridged_norm = 0.0;
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      fit_norm += fit.data()[k] * fit.data()[k];
+      ridged_norm += ridged.data()[k] * ridged.data()[k];
+    }
+    REQUIRE(ridged_norm < fit_norm);
+    /* A ridge makes underdetermined fits well posed; with
+     * fewer samples than coefficients the solution is
+     * A^T (A A^T + ridge I)^-1 b */
+    constexpr const double ridge = 0.1;
+    constexpr const int n = 5;
+    REQUIRE(int(few.size()) == n);
+    static_assert(n < Poly::num_coeffs,
+                  "The fit must be underdetermined");
+    Poly underdetermined((Tags::Zero_Tag()));
+    REQUIRE(least_squares_fit(few, values.data(),
+                              underdetermined, nullptr,
+                              ridge));
+    const BatchEvaluator<double, degree, dim> vandermonde(
+        few);
+    double gram[n][n];
+    double y[n];
+    for(int i = 0; i < n; i++) {
+      for(int j = 0; j < n; j++) {
+        gram[i][j] = i == j ? ridge : 0.0;
+        for(int k = 0; k < Poly::num_coeffs; k++) {
+          gram[i][j] += vandermonde.monomials(i)[k] *
+                        vandermonde.monomials(j)[k];
+        }
+      }
+      y[i] = values[i];
+    }
+    /* The Gram matrix is positive definite, so Gaussian
+     * elimination doesn't need to pivot */
+    for(int c = 0; c < n; c++) {
+      for(int r = c + 1; r < n; r++) {
+        const double f = gram[r][c] / gram[c][c];
+        for(int j = c; j < n; j++) {
+          gram[r][j] -= f * gram[c][j];
+        }
+        y[r] -= f * y[c];
+      }
+    }
+    for(int r = n - 1; r >= 0; r--) {
+      for(int j = r + 1; j < n; j++) {
+        y[r] -= gram[r][j] * y[j];
+      }
+      y[r] /= gram[r][r];
+    }
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      double expected = 0.0;
+      for(int i = 0; i < n; i++) {
+        expected += vandermonde.monomials(i)[k] * y[i];
+      }
+      REQUIRE(underdetermined.data()[k] ==
+              Approx(expected));
+    }
+  }
+  SECTION("Batched") {
+    constexpr const int sets = 13;
+    std::vector<std::vector<Array<double, dim> > >
+        point_sets;
+    std::vector<std::vector<double> > value_sets;
+    std::vector<std::vector<double> > weight_sets;
+    for(int s = 0; s < sets; s++) {
+      point_sets.push_back(random_points(12 + s));
+      std::vector<double> v, w;
+      for(const auto &pt : point_sets.back()) {
+        v.push_back(std::sin(3.0 * pt[0]) * pt[1]);
+        w.push_back(1.0 + 0.5 * pdf(rng));
+      }
+      value_sets.push_back(v);
+      weight_sets.push_back(w);
+    }
+    /* Too few samples in one set */
+    point_sets[4].resize(3);
+    value_sets[4].resize(3);
+    weight_sets[4].resize(3);
+    Parallel::Scheduler sched(4);
+    std::vector<Poly> fits(sets, Poly(Tags::Zero_Tag()));
+    REQUIRE(least_squares_fit(sched, point_sets,
+                              value_sets, fits.data(),
+                              &weight_sets) == 1);
+    for(int s = 0; s < sets; s++) {
+      Poly serial((Tags::Zero_Tag()));
+      least_squares_fit(point_sets[s], value_sets[s].data(),
+                        serial, weight_sets[s].data());
+      for(int k = 0; k < Poly::num_coeffs; k++) {
+        REQUIRE(fits[s].data()[k] == serial.data()[k]);
+      }
+    }
+  }
+}
+
+template <int degree, int other_degree, int dim>
+void check_fft_product(std::mt19937_64 &rng) {
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  Polynomial<double, degree, dim> p;
+  Polynomial<double, other_degree, dim> q;
+  for(int k = 0; k < p.num_coeffs; k++) {
+    p.data()[k] = pdf(rng);
+  }
+  for(int k = 0; k < q.num_coeffs; k++) {
+    q.data()[k] = pdf(rng);
+  }
+  const auto dense = p.product(q);
+  const auto fft = fft_product(p, q);
+  const auto fast = fast_product(p, q);
+  for(int k = 0; k < dense.num_coeffs; k++) {
+    REQUIRE(std::abs(fft.data()[k] - dense.data()[k]) <
+            1e-12);
+    REQUIRE(std::abs(fast.data()[k] - dense.data()[k]) <
+            1e-12);
+  }
+}
+
+TEST_CASE("FFT Product", "[Polynomial]") {
+  std::mt19937_64 rng(46);
+  check_fft_product<0, 0, 1>(rng);
+  check_fft_product<7, 3, 1>(rng);
+  check_fft_product<0, 4, 2>(rng);
+  check_fft_product<5, 8, 2>(rng);
+  check_fft_product<12, 12, 2>(rng);
+  check_fft_product<4, 3, 3>(rng);
+  check_fft_product<6, 6, 3>(rng);
+  check_fft_product<2, 3, 4>(rng);
+  /* Multiplying by a linear polynomial is cheap densely,
+   * but it pads the 3D FFT to the full product length */
+  REQUIRE((!use_fft_product<double, 7, 1, 3>()));
+  REQUIRE((use_fft_product<double, 1, 1, 2>()));
+  REQUIRE((use_fft_product<double, 12, 12, 3>()));
+  REQUIRE((!use_fft_product<Fraction, 12, 12, 2>()));
+  /* Non floating point coefficients keep the exact dense
+   * product */
+  Polynomial<Fraction, 1, 1> f((Tags::Zero_Tag()));
+  f.coeff(0) = Fraction(1, 3);
+  f.coeff(1) = Fraction(1, 2);
+  const auto sq = fast_product(f, f);
+  REQUIRE(sq.coeff(0) == Fraction(1, 9));
+  REQUIRE(sq.coeff(1) == Fraction(1, 3));
+  REQUIRE(sq.coeff(2) == Fraction(1, 4));
+}
+
+TEST_CASE("Vector Polynomial", "[Polynomial]") {
+  constexpr const int dim = 3;
+  constexpr const int degree = 4;
+  using Poly = Polynomial<double, degree, dim>;
+  using Vector = VectorPolynomial<double, degree, dim>;
+  std::mt19937_64 rng(47);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  Array<Poly, dim> u;
+  for(int c = 0; c < dim; c++) {
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      u[c].data()[k] = pdf(rng);
+    }
+  }
+  const Vector vec(u);
+  const auto grad = vec.grad();
+  const auto div = vec.div();
+  const auto curl = vec.curl();
+  const auto lap = vec.laplacian();
+  for(int t = 0; t < 10; t++) {
+    Array<double, dim> x;
+    for(int d = 0; d < dim; d++) {
+      x[d] = pdf(rng);
+    }
+    auto deriv = [&](int c, int v) {
+      return u[c].differentiate(v).eval(x[0], x[1], x[2]);
+    };
+    const Vector::Value value = vec.eval(x);
+    const Vector::Jacobian J = vec.eval_gradient(x);
+    const auto grad_value = grad.eval(x);
+    double expected_div = 0.0;
+    for(int c = 0; c < dim; c++) {
+      REQUIRE(value[c] ==
+              Approx(u[c].eval(x[0], x[1], x[2])));
+      double expected_lap = 0.0;
+      for(int v = 0; v < dim; v++) {
+        REQUIRE(J[c][v] == Approx(deriv(c, v)));
+        REQUIRE(grad_value[c * dim + v] ==
+                Approx(deriv(c, v)));
+        expected_lap += u[c]
+                            .differentiate(v)
+                            .differentiate(v)
+                            .eval(x[0], x[1], x[2]);
+      }
+      expected_div += deriv(c, c);
+      REQUIRE(lap.eval(x)[c] == Approx(expected_lap));
+    }
+    REQUIRE(div.eval(x[0], x[1], x[2]) ==
+            Approx(expected_div));
+    const auto curl_value = curl.eval(x);
+    REQUIRE(curl_value[0] ==
+            Approx(deriv(2, 1) - deriv(1, 2)));
+    REQUIRE(curl_value[1] ==
+            Approx(deriv(0, 2) - deriv(2, 0)));
+    REQUIRE(curl_value[2] ==
+            Approx(deriv(1, 0) - deriv(0, 1)));
+  }
+  SECTION("Components") {
+    for(int c = 0; c < dim; c++) {
+      const Poly p = vec.component(c);
+      for(int k = 0; k < Poly::num_coeffs; k++) {
+        REQUIRE(p.data()[k] == u[c].data()[k]);
+      }
+    }
+    const Vector twice = vec + vec * 3.0 - 2.0 * vec;
+    for(int k = 0; k < Poly::num_coeffs; k++) {
+      REQUIRE(twice.coeff(k, 1) ==
+              Approx(2.0 * u[1].data()[k]));
+    }
+  }
+  SECTION("2D") {
+    /* u = (-y, x) rotates with curl 2 and divergence 0 */
+    VectorPolynomial<double, 1, 2> rot((Tags::Zero_Tag()));
+    const int x_idx =
+        Utilities::term_index(Array<int, 2>(1, 0));
+    const int y_idx =
+        Utilities::term_index(Array<int, 2>(0, 1));
+    rot.coeff(y_idx, 0) = -1.0;
+    rot.coeff(x_idx, 1) = 1.0;
+    const Array<double, 2> x(0.3, -0.7);
+    REQUIRE(rot.curl().eval(x)[0] == Approx(2.0));
+    REQUIRE(rot.div().coeff(0, 0) == Approx(0.0));
+    REQUIRE(rot.laplacian().eval(x)[1] == Approx(0.0));
+    /* Two components in 3D give a 2x3 gradient */
+    VectorPolynomial<double, 2, 3, 2> w((Tags::Zero_Tag()));
+    w.set_component(1, u[0].differentiate(0).differentiate(
+                           1));
+    const Array<double, 3> y(0.1, 0.2, -0.4);
+    const auto J = w.eval_gradient(y);
+    REQUIRE(J[1][2] ==
+            Approx(u[0].differentiate(0)
+                       .differentiate(1)
+                       .differentiate(2)
+                       .eval(y[0], y[1], y[2])));
+    REQUIRE(J[0][2] == 0.0);
+  }
+}
+
+TEST_CASE("Kernel Code Generation", "[IO]") {
+  using Poly = Polynomial<double, 2, 2>;
+  const int x = Utilities::term_index(Array<int, 2>(1, 0));
+  const int xx = Utilities::term_index(Array<int, 2>(2, 0));
+  const int xy = Utilities::term_index(Array<int, 2>(1, 1));
+  /* 1 - x and 0.5 x^2 + 2 x y */
+  std::vector<Poly> functions(2, Poly(Tags::Zero_Tag()));
+  functions[0].data()[0] = 1.0;
+  functions[0].data()[x] = -1.0;
+  functions[1].data()[xx] = 0.5;
+  functions[1].data()[xy] = 2.0;
+  std::ostringstream header;
+  IO::write_kernel_header(header, "test_kernel", functions);
+  const std::string code = header.str();
+  auto contains = [&](const std::string &s) {
+    return code.find(s) != std::string::npos;
+  };
+  REQUIRE(contains("#ifndef KERNEL_TEST_KERNEL_HPP_"));
+  REQUIRE(contains("namespace test_kernel {"));
+  REQUIRE(contains("num_functions = 2;"));
+  /* Shared monomials, built from their parents */
+  REQUIRE(contains("const double m_1_0 = x[0];"));
+  REQUIRE(contains("const double m_1_1 = m_0_1 * x[0];"));
+  REQUIRE(contains("values[0] = 1.0 - m_1_0;"));
+  REQUIRE(contains(
+      "values[1] = 2.0 * m_1_1 + 0.5 * m_2_0;"));
+  /* y^2 has no nonzero coefficients */
+  REQUIRE(!contains("m_0_2"));
+  /* d/dx (0.5 x^2 + 2 x y) = x + 2 y */
+  REQUIRE(contains("gradients[2] = 2.0 * m_0_1 + m_1_0;"));
+  REQUIRE(contains("gradients[3] = 2.0 * m_1_0;"));
+  REQUIRE(contains("gradients[1] = 0.0;"));
+  /* File names aren't always identifiers */
+  std::ostringstream renamed;
+  IO::write_kernel_header(renamed, "2d-basis.p2",
+                          functions);
+  const std::string renamed_code = renamed.str();
+  REQUIRE(renamed_code.find("namespace _2d_basis_p2 {") !=
+          std::string::npos);
+  REQUIRE(renamed_code.find(
+              "#ifndef KERNEL_2D_BASIS_P2_HPP_") !=
+          std::string::npos);
+  /* Only the leading digit differs from the name above */
+  std::ostringstream other;
+  IO::write_kernel_header(other, "1d-basis.p2", functions);
+  REQUIRE(other.str().find("namespace _1d_basis_p2 {") !=
+          std::string::npos);
+  /* Doubled underscores are reserved */
+  std::ostringstream doubled;
+  IO::write_kernel_header(doubled, "basis__", functions);
+  REQUIRE(doubled.str().find(
+              "#ifndef KERNEL_BASIS_HPP_") !=
+          std::string::npos);
+  /* inf and nan have no literals */
+  functions[1].data()[x] = std::nan("");
+  std::ostringstream rejected;
+  REQUIRE_THROWS_AS(IO::write_kernel_header(
+                        rejected, "test_kernel", functions),
+                    std::domain_error);
+  REQUIRE(rejected.str().empty());
+}
+
+TEST_CASE("Grid Evaluation", "[Polynomial]") {
+  std::mt19937_64 rng(49);
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  auto random_axis = [&](int n) {
+    std::vector<double> axis(n);
+    for(double &x : axis) {
+      x = pdf(rng);
+    }
+    return axis;
+  };
+  SECTION("3D") {
+    Polynomial<double, 5, 3> p;
+    for(int k = 0; k < p.num_coeffs; k++) {
+      p.data()[k] = pdf(rng);
+    }
+    const std::vector<double> xs = random_axis(4);
+    const std::vector<double> ys = random_axis(7);
+    const std::vector<double> zs = random_axis(5);
+    std::vector<double> grid(xs.size() * ys.size() *
+                             zs.size());
+    eval_grid(p, xs, ys, zs, grid.data());
+    int idx = 0;
+    for(double x : xs) {
+      for(double y : ys) {
+        for(double z : zs) {
+          REQUIRE(grid[idx++] == Approx(p.eval(x, y, z)));
+        }
+      }
+    }
+  }
+  SECTION("2D") {
+    Polynomial<double, 3, 2> p;
+    for(int k = 0; k < p.num_coeffs; k++) {
+      p.data()[k] = pdf(rng);
+    }
+    const std::vector<std::vector<double> > axes{
+        random_axis(6), random_axis(3)};
+    std::vector<double> grid(18);
+    eval_grid(p, axes, grid.data());
+    for(int i = 0; i < 6; i++) {
+      for(int j = 0; j < 3; j++) {
+        REQUIRE(grid[i * 3 + j] ==
+                Approx(p.eval(axes[0][i], axes[1][j])));
+      }
+    }
+  }
+  SECTION("Exact") {
+    /* x y^2 - 3 z + 1/2 */
+    Polynomial<Fraction, 3, 3> p((Tags::Zero_Tag()));
+    p.coeff(1, 2, 0) = 1;
+    p.coeff(0, 0, 1) = -3;
+    p.coeff(0, 0, 0) = Fraction(1, 2);
+    const std::vector<Fraction> xs{Fraction(1, 3), 2};
+    const std::vector<Fraction> ys{Fraction(-1), 3};
+    const std::vector<Fraction> zs{Fraction(0), 1};
+    std::vector<Fraction> grid(8);
+    eval_grid(p, xs, ys, zs, grid.data());
+    REQUIRE(grid[0] == Fraction(5, 6));
+    REQUIRE(grid[3] == Fraction(1, 2));
+    REQUIRE(grid[7] == Fraction(31, 2));
+  }
+}
+
+TEST_CASE("Gauss-Legendre Quadrature", "[Quadrature]") {
+  for(int n = 1; n <= 6; n++) {
+    const auto rule =
+        Quadrature<double, 3>::gauss_legendre(n);
+    REQUIRE(rule.size() == n * n * n);
+    /* Exact for x^a y^b z^c up to degree 2 n - 1 in each
+     * variable */
+    for(int a = 0; a < 2 * n; a++) {
+      for(int b = 0; b < 2 * n; b += 2) {
+        const int c = 2 * n - 1 - a % 2;
+        double sum = 0.0;
+        for(int q = 0; q < rule.size(); q++) {
+          const auto &x = rule.point(q);
+          sum += rule.weight(q) * std::pow(x[0], a) *
+                 std::pow(x[1], b) * std::pow(x[2], c);
+        }
+        const double exact =
+            1.0 / ((a + 1) * (b + 1) * (c + 1));
+        REQUIRE(sum == Approx(exact));
+      }
+    }
+  }
+  const auto midpoint =
+      Quadrature<double, 2>::gauss_legendre(1);
+  REQUIRE(midpoint.point(0)[0] == Approx(0.5));
+  REQUIRE(midpoint.weight(0) == Approx(1.0));
+}
+
+template <int degree>
+void fill_and_widen(std::mt19937_64 &rng,
+                    Polynomial<double, degree, 2> &p,
+                    Polynomial<double, 2, 2> &wide) {
+  std::uniform_real_distribution<double> pdf(-1.0, 1.0);
+  wide = Polynomial<double, 2, 2>(Tags::Zero_Tag());
+  for(int k = 0; k < p.num_coeffs; k++) {
+    p.data()[k] = pdf(rng);
+    wide.data()[k] = p.data()[k];
+  }
+}
+
+TEST_CASE("Basis Tabulation", "[Quadrature]") {
+  using Tabulation = BasisTabulation<double, 2, 2>;
+  std::mt19937_64 rng(50);
+  Tabulation::tuple_type basis;
+  std::vector<Polynomial<double, 2, 2> > wide(
+      Tabulation::num_functions);
+  fill_and_widen(rng, std::get<0>(basis), wide[0]);
+  fill_and_widen(rng, std::get<1>(basis), wide[1]);
+  fill_and_widen(rng, std::get<2>(basis), wide[2]);
+  fill_and_widen(rng, std::get<3>(basis), wide[3]);
+  fill_and_widen(rng, std::get<4>(basis), wide[4]);
+  fill_and_widen(rng, std::get<5>(basis), wide[5]);
+  const auto rule =
+      Quadrature<double, 2>::gauss_legendre(3);
+  const auto tab = Tabulation::cached(basis, rule, true);
+  REQUIRE(tab->num_points() == 9);
+  REQUIRE(tab->stride() % Tabulation::row_multiple == 0);
+  REQUIRE(tab->stride() >= tab->num_points());
+  for(int f = 0; f < Tabulation::num_functions; f++) {
+    REQUIRE(reinterpret_cast<std::uintptr_t>(
+                tab->values(f)) %
+                Tabulation::alignment ==
+            0);
+    for(int q = 0; q < tab->num_points(); q++) {
+      const auto &x = rule.point(q);
+      REQUIRE(tab->values(f)[q] ==
+              Approx(wide[f].eval(x[0], x[1])));
+      for(int v = 0; v < 2; v++) {
+        const auto d = wide[f].differentiate(v);
+        REQUIRE(tab->gradients(v, f)[q] ==
+                Approx(d.eval(x[0], x[1])));
+        for(int w = 0; w < 2; w++) {
+          REQUIRE(tab->hessians(v, w, f)[q] ==
+                  Approx(d.differentiate(w).coeff(0, 0)));
+        }
+      }
+    }
+    for(int q = tab->num_points(); q < tab->stride(); q++) {
+      REQUIRE(tab->values(f)[q] == 0.0);
+      REQUIRE(tab->weights()[q] == 0.0);
+    }
+  }
+  /* The interpolated values integrate like the
+   * polynomial */
+  const std::vector<double> dofs{0.5, -1.0, 2.0,
+                                 0.25, 1.5, -0.75};
+  std::vector<double> at_points(tab->stride());
+  tab->interpolate(tab->values(), dofs.data(),
+                   at_points.data());
+  double integral = 0.0;
+  Polynomial<double, 2, 2> u((Tags::Zero_Tag()));
+  for(int f = 0; f < Tabulation::num_functions; f++) {
+    u = u + wide[f] * dofs[f];
+  }
+  for(int q = 0; q < tab->stride(); q++) {
+    integral += tab->weights()[q] * at_points[q];
+  }
+  const Array<double, 2> lo((Tags::Zero_Tag()));
+  const Array<double, 2> hi(1.0, 1.0);
+  REQUIRE(integral == Approx(integrate_box(u, lo, hi)));
+  /* The cache shares tabulations of the same basis and
+   * rule, with or without Hessians */
+  REQUIRE(Tabulation::cached(basis, rule) == tab);
+  const auto other = Tabulation::cached(
+      basis, Quadrature<double, 2>::gauss_legendre(2));
+  REQUIRE(other != tab);
+  REQUIRE(!other->has_hessians());
+  REQUIRE(other->num_points() == 4);
+}